@@ -0,0 +1,294 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Inflate.h"
+
+enum class LoadResult
+{
+	Ok,
+	NotFound,
+	ReadError,
+	TooLarge,
+	Corrupt
+};
+
+inline const char* describe(LoadResult result)
+{
+	switch (result)
+	{
+	case LoadResult::Ok: return "ok";
+	case LoadResult::NotFound: return "file not found";
+	case LoadResult::ReadError: return "read error";
+	case LoadResult::TooLarge: return "ROM does not fit in memory";
+	case LoadResult::Corrupt: return "corrupt archive";
+	}
+
+	return "unknown error";
+}
+
+// ROM sources: plain files, gzip files and members of zip archives.
+// A zip member is addressed as a path through the archive, e.g. roms.zip/games/pong.ch8.
+namespace Archive
+{
+	struct ZipEntry
+	{
+		std::string name;
+		uint16_t method;
+		uint32_t crc;
+		uint32_t compressedSize;
+		uint32_t size;
+		uint32_t localHeaderOffset;
+	};
+
+	inline uint16_t readLE16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+	inline uint32_t readLE32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24); }
+
+	inline bool hasExtension(const std::filesystem::path& path, const char* extension)
+	{
+		std::string actual = path.extension().string();
+		std::transform(actual.begin(), actual.end(), actual.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return actual == extension;
+	}
+
+	// Lists the unencrypted stored or deflated files of a zip archive from its central directory.
+	inline bool listZip(const std::filesystem::path& archive, std::vector<ZipEntry>& entries)
+	{
+		std::ifstream ifs(archive, std::ios::binary | std::ios::ate);
+		if (!ifs) return false;
+
+		// The end of central directory record is 22 bytes plus a comment of up to 64 KB.
+		const uint64_t fileSize = static_cast<uint64_t>(ifs.tellg());
+		const size_t tailSize = static_cast<size_t>(std::min<uint64_t>(fileSize, 22 + 0xFFFF));
+		std::vector<uint8_t> tail(tailSize);
+		ifs.seekg(static_cast<std::streamoff>(fileSize - tailSize));
+		if (tailSize < 22 || !ifs.read(reinterpret_cast<char*>(tail.data()), tailSize)) return false;
+
+		size_t eocd = tailSize - 22;
+		while (readLE32(&tail[eocd]) != 0x06054B50)
+		{
+			if (eocd-- == 0) return false;
+		}
+
+		const uint16_t entryCount = readLE16(&tail[eocd + 10]);
+		const uint32_t directorySize = readLE32(&tail[eocd + 12]);
+		const uint32_t directoryOffset = readLE32(&tail[eocd + 16]);
+		if (static_cast<uint64_t>(directoryOffset) + directorySize > fileSize) return false;
+
+		std::vector<uint8_t> directory(directorySize);
+		ifs.seekg(directoryOffset);
+		if (!ifs.read(reinterpret_cast<char*>(directory.data()), directorySize)) return false;
+
+		size_t pos { 0 };
+		for (int i = 0; i < entryCount; i++)
+		{
+			if (pos + 46 > directory.size() || readLE32(&directory[pos]) != 0x02014B50) return false;
+
+			const uint8_t* header = &directory[pos];
+			const uint16_t nameLength = readLE16(header + 28);
+			const size_t next = pos + 46 + nameLength + readLE16(header + 30) + readLE16(header + 32);
+			if (next > directory.size()) return false;
+
+			ZipEntry entry { std::string(reinterpret_cast<const char*>(header + 46), nameLength), readLE16(header + 10),
+				readLE32(header + 16), readLE32(header + 20), readLE32(header + 24), readLE32(header + 42) };
+
+			const bool encrypted = (readLE16(header + 8) & 1) != 0;
+			const bool isDirectory = !entry.name.empty() && entry.name.back() == '/';
+			if (!encrypted && !isDirectory && (entry.method == 0 || entry.method == 8))
+				entries.push_back(std::move(entry));
+
+			pos = next;
+		}
+
+		return true;
+	}
+
+	// Splits roms.zip/games/pong.ch8 into the archive file and the member name.
+	inline bool splitZipPath(const std::filesystem::path& path, std::filesystem::path& archive, std::string& member)
+	{
+		std::error_code error;
+		for (std::filesystem::path parent = path.parent_path(); !parent.empty() && parent != parent.parent_path(); parent = parent.parent_path())
+		{
+			if (hasExtension(parent, ".zip") && std::filesystem::is_regular_file(parent, error))
+			{
+				archive = parent;
+				member = path.lexically_relative(parent).generic_string();
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Decompresses (or copies) size bytes of stream into out and checks them against crc.
+	inline LoadResult extract(std::istream& in, bool deflated, uint64_t compressedSize, uint32_t crc, uint8_t* out, size_t capacity, size_t& size)
+	{
+		if (deflated)
+		{
+			Inflater inflater(in, compressedSize);
+			switch (inflater.inflate(out, capacity, size))
+			{
+			case Inflater::Ok: break;
+			case Inflater::TooLarge: return LoadResult::TooLarge;
+			case Inflater::Truncated: return LoadResult::ReadError;
+			default: return LoadResult::Corrupt;
+			}
+		}
+		else
+		{
+			if (compressedSize > capacity) return LoadResult::TooLarge;
+
+			in.read(reinterpret_cast<char*>(out), static_cast<std::streamsize>(compressedSize));
+			size = static_cast<size_t>(in.gcount());
+			if (size != compressedSize) return LoadResult::ReadError;
+		}
+
+		return crc32(out, size) == crc ? LoadResult::Ok : LoadResult::Corrupt;
+	}
+
+	// Reads a member found by listZip, for callers reading several members of one archive.
+	inline LoadResult readZipMember(const std::filesystem::path& archive, const ZipEntry& entry, uint8_t* out, size_t capacity, size_t& size)
+	{
+		if (entry.size > capacity) return LoadResult::TooLarge;
+
+		std::ifstream ifs(archive, std::ios::binary);
+		uint8_t local[30];
+		ifs.seekg(entry.localHeaderOffset);
+		if (!ifs.read(reinterpret_cast<char*>(local), sizeof(local)) || readLE32(local) != 0x04034B50) return LoadResult::Corrupt;
+
+		ifs.seekg(readLE16(local + 26) + readLE16(local + 28), std::ios::cur);
+		const LoadResult result = extract(ifs, entry.method == 8, entry.compressedSize, entry.crc, out, capacity, size);
+		return result == LoadResult::Ok && size != entry.size ? LoadResult::Corrupt : result;
+	}
+
+	inline LoadResult readZipMember(const std::filesystem::path& archive, const std::string& member, uint8_t* out, size_t capacity, size_t& size)
+	{
+		std::vector<ZipEntry> entries;
+		if (!listZip(archive, entries)) return LoadResult::Corrupt;
+
+		const auto entry = std::find_if(entries.begin(), entries.end(), [&](const ZipEntry& e) { return e.name == member; });
+		if (entry == entries.end()) return LoadResult::NotFound;
+
+		return readZipMember(archive, *entry, out, capacity, size);
+	}
+
+	inline LoadResult readGzip(const std::filesystem::path& path, uint8_t* out, size_t capacity, size_t& size)
+	{
+		std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+		if (!ifs) return LoadResult::NotFound;
+
+		const uint64_t fileSize = static_cast<uint64_t>(ifs.tellg());
+		ifs.seekg(0);
+
+		uint8_t header[10];
+		if (!ifs.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != 0x1F || header[1] != 0x8B || header[2] != 8)
+			return LoadResult::Corrupt;
+
+		const uint8_t flags = header[3];
+		if (flags & 0x04)
+		{
+			uint8_t extraLength[2];
+			ifs.read(reinterpret_cast<char*>(extraLength), 2);
+			ifs.seekg(readLE16(extraLength), std::ios::cur);
+		}
+		if (flags & 0x08) ifs.ignore(std::numeric_limits<std::streamsize>::max(), '\0');
+		if (flags & 0x10) ifs.ignore(std::numeric_limits<std::streamsize>::max(), '\0');
+		if (flags & 0x02) ifs.seekg(2, std::ios::cur);
+
+		const int64_t dataStart = ifs.tellg();
+		if (!ifs || dataStart < 0 || static_cast<uint64_t>(dataStart) + 8 > fileSize) return LoadResult::Corrupt;
+
+		uint8_t trailer[8];
+		std::ifstream trailerStream(path, std::ios::binary);
+		trailerStream.seekg(static_cast<std::streamoff>(fileSize - 8));
+		if (!trailerStream.read(reinterpret_cast<char*>(trailer), sizeof(trailer))) return LoadResult::ReadError;
+
+		const LoadResult result = extract(ifs, true, fileSize - 8 - dataStart, readLE32(trailer), out, capacity, size);
+		return result == LoadResult::Ok && size != readLE32(trailer + 4) ? LoadResult::Corrupt : result;
+	}
+
+#ifndef _WIN32
+	// Reads a whole regular file from an open descriptor with pread, leaving its offset untouched.
+	inline LoadResult readFile(int fd, uint8_t* out, size_t capacity, size_t& size)
+	{
+		struct stat info;
+		if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) return LoadResult::ReadError;
+		if (static_cast<uint64_t>(info.st_size) > capacity) return LoadResult::TooLarge;
+
+		size = 0;
+		while (size < static_cast<size_t>(info.st_size))
+		{
+			const ssize_t count = pread(fd, out + size, static_cast<size_t>(info.st_size) - size, static_cast<off_t>(size));
+			if (count < 0 && errno == EINTR) continue;
+			if (count <= 0) return LoadResult::ReadError;
+
+			size += static_cast<size_t>(count);
+		}
+
+		return LoadResult::Ok;
+	}
+#endif
+
+	inline LoadResult readFile(const std::filesystem::path& path, uint8_t* out, size_t capacity, size_t& size)
+	{
+#ifndef _WIN32
+		const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) return errno == ENOENT ? LoadResult::NotFound : LoadResult::ReadError;
+
+		const LoadResult result = readFile(fd, out, capacity, size);
+		close(fd);
+		return result;
+#else
+		std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+		if (!ifs) return LoadResult::NotFound;
+
+		const std::ifstream::pos_type pos = ifs.tellg();
+		if (pos < 0) return LoadResult::ReadError;
+		if (static_cast<uint64_t>(pos) > capacity) return LoadResult::TooLarge;
+
+		ifs.seekg(0, std::ios::beg);
+		ifs.read(reinterpret_cast<char*>(out), pos);
+		size = static_cast<size_t>(ifs.gcount());
+		return size == static_cast<size_t>(pos) ? LoadResult::Ok : LoadResult::ReadError;
+#endif
+	}
+
+	// Reads a ROM from any supported source into out, failing with TooLarge if it does not fit in capacity bytes.
+	inline LoadResult readRom(const std::filesystem::path& path, uint8_t* out, size_t capacity, size_t& size)
+	{
+		std::filesystem::path archive;
+		std::string member;
+		std::error_code error;
+
+		if (!std::filesystem::is_regular_file(path, error) && splitZipPath(path, archive, member))
+			return readZipMember(archive, member, out, capacity, size);
+
+		// A bare archive loads its first file.
+		if (hasExtension(path, ".zip"))
+		{
+			std::vector<ZipEntry> entries;
+			if (!listZip(path, entries)) return std::filesystem::exists(path, error) ? LoadResult::Corrupt : LoadResult::NotFound;
+			if (entries.empty()) return LoadResult::NotFound;
+
+			return readZipMember(path, entries.front(), out, capacity, size);
+		}
+		if (hasExtension(path, ".gz"))
+			return readGzip(path, out, capacity, size);
+
+		return readFile(path, out, capacity, size);
+	}
+}
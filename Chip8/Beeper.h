@@ -0,0 +1,168 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// The buzzer, driven by on/off edges timestamped in emulated seconds.
+// The emulation thread pushes edges and publishes its clock; the audio thread plays
+// them back a short, fixed lead behind that clock, so each edge lands on the exact
+// sample it belongs to instead of on a callback boundary. The tone is a PolyBLEP
+// band-limited square and the gate ramps over a couple of milliseconds to avoid clicks.
+// Both sides are lock-free and render() never allocates.
+class Beeper
+{
+public:
+	static constexpr size_t Capacity = 1024;
+	static constexpr double Frequency = 440.0;
+	static constexpr double RampSeconds = 0.002;
+	// Playback runs this far behind the emulation clock, which covers a frame's burst of cycles.
+	static constexpr double TargetLead = 0.03;
+	// Outside this window the playback position is re-anchored to the clock.
+	static constexpr double MaxLead = 0.15;
+	static constexpr double MaxLag = 0.02;
+	// Output fades out once the clock has not moved for this long, e.g. while paused.
+	static constexpr double StallSeconds = 0.1;
+
+	struct Event
+	{
+		double time;
+		bool on;
+	};
+
+	void setSampleRate(uint32_t rate) { sampleRate = rate; }
+	uint32_t getSampleRate() const { return sampleRate; }
+	void setVolume(float value) { volume.store(value, std::memory_order_relaxed); }
+
+	// Emulation thread. Edges are dropped if the audio thread has fallen a full queue behind.
+	bool push(double time, bool on)
+	{
+		const size_t index = head.load(std::memory_order_relaxed);
+		if (index - tail.load(std::memory_order_acquire) == Capacity) return false;
+
+		events[index % Capacity] = { time, on };
+		head.store(index + 1, std::memory_order_release);
+		return true;
+	}
+	void advance(double time)
+	{
+		clock.store(time, std::memory_order_release);
+	}
+	// How far the emulation clock is ahead of playback, in seconds.
+	double getLead() const
+	{
+		return clock.load(std::memory_order_acquire) - position.load(std::memory_order_acquire);
+	}
+
+	// Audio thread. Writes frameCount interleaved frames of channels samples each.
+	void render(float* out, uint32_t frameCount, uint32_t channels)
+	{
+		const double latest = clock.load(std::memory_order_acquire);
+		const double lead = latest - playTime;
+		if (lead > MaxLead || lead < -MaxLag)
+			playTime = latest - TargetLead;
+
+		stalledFrames = latest == lastClock ? stalledFrames + frameCount : 0;
+		lastClock = latest;
+		const bool stalled = stalledFrames > StallSeconds * sampleRate;
+
+		const double sampleTime = 1.0 / sampleRate;
+		const double phaseStep = Frequency * sampleTime;
+		const float rampStep = static_cast<float>(sampleTime / RampSeconds);
+		const float gain = volume.load(std::memory_order_relaxed);
+
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			size_t index = tail.load(std::memory_order_relaxed);
+			while (index != head.load(std::memory_order_acquire) && events[index % Capacity].time <= playTime)
+			{
+				gate = events[index % Capacity].on;
+				tail.store(++index, std::memory_order_release);
+			}
+
+			const bool audible = gate && !stalled;
+			envelope = audible ? std::min(envelope + rampStep, 1.0f) : std::max(envelope - rampStep, 0.0f);
+
+			float sample { 0.0f };
+			if (envelope > 0.0f)
+			{
+				double square = phase < 0.5 ? 1.0 : -1.0;
+				square += polyBlep(phase, phaseStep);
+				square -= polyBlep(phase < 0.5 ? phase + 0.5 : phase - 0.5, phaseStep);
+				sample = static_cast<float>(square) * envelope * gain;
+
+				phase += phaseStep;
+				if (phase >= 1.0) phase -= 1.0;
+			}
+			else
+				phase = 0.0;
+
+			std::fill(out + frame * channels, out + (frame + 1) * channels, sample);
+			playTime += sampleTime;
+		}
+
+		position.store(playTime, std::memory_order_release);
+	}
+
+private:
+	std::array<Event, Capacity> events{};
+	std::atomic<size_t> head { 0 };
+	std::atomic<size_t> tail { 0 };
+	std::atomic<double> clock { 0.0 };
+	std::atomic<double> position { 0.0 };
+	std::atomic<float> volume { 0.5f };
+	uint32_t sampleRate { 44100 };
+
+	// Audio thread state.
+	double playTime { 0.0 };
+	double lastClock { 0.0 };
+	uint64_t stalledFrames { 0 };
+	double phase { 0.0 };
+	float envelope { 0.0f };
+	bool gate { false };
+
+	// Residual that rounds off a unit step at phase 0 over one sample either side.
+	static double polyBlep(double t, double dt)
+	{
+		if (t < dt)
+		{
+			t /= dt;
+			return t + t - t * t - 1.0;
+		}
+		if (t > 1.0 - dt)
+		{
+			t = (t - 1.0) / dt;
+			return t * t + t + t + 1.0;
+		}
+		return 0.0;
+	}
+};
+
+// Scales the frame rate by up to MaxRateDelta so the beeper's lead over playback holds at its
+// target, instead of the display and audio clocks drifting apart over long runs.
+class AudioRateControl
+{
+public:
+	static constexpr double MaxRateDelta = 0.005;
+	static constexpr double Smoothing = 0.02;
+
+	// Once per frame, with Beeper::getLead.
+	void update(double lead)
+	{
+		smoothedLead += (lead - smoothedLead) * Smoothing;
+		// A frame of error applies the full correction.
+		rateScale = 1.0 - std::clamp((smoothedLead - Beeper::TargetLead) * 60.0, -1.0, 1.0) * MaxRateDelta;
+	}
+	void reset()
+	{
+		smoothedLead = Beeper::TargetLead;
+		rateScale = 1.0;
+	}
+
+	double getLead() const { return smoothedLead; }
+	double getRateScale() const { return rateScale; }
+
+private:
+	double smoothedLead { Beeper::TargetLead };
+	double rateScale { 1.0 };
+};
@@ -1,49 +1,139 @@
+#pragma once
+#include <algorithm>
+#include <array>
 #include <bitset>
 #include <cstddef>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <random>
+#include <span>
+#include <utility>
 #include "MiniAudio/miniaudio.h"
+#include "Archive.h"
 #include "Quirks.h"
+#include "PagedRAM.h"
+#include "StateHash.h"
+#include "Trace.h"
+#include "Coverage.h"
+#include "Beeper.h"
 
-struct soundData
-{
-	ma_waveform* waveForm;
-	uint8_t& soundTimer;
-	bool& enableSound;
-};
+#ifdef CHIP8_PROFILER
+#include <chrono>
+#include "Profiler.h"
+#endif
 
 inline void sound_data_callback(ma_device* pDevice, void* pOutput, const void* pInput, ma_uint32 frameCount)
 {
-	soundData* data = (soundData*)pDevice->pUserData;
-	if (data->waveForm == nullptr)
+	Beeper* beeper = static_cast<Beeper*>(pDevice->pUserData);
+	const ma_uint32 channels = pDevice->playback.channels;
+
+	if (pDevice->playback.format == ma_format_f32)
+	{
+		beeper->render(static_cast<float*>(pOutput), frameCount, channels);
 		return;
+	}
 
-	if (data->enableSound && data->soundTimer > 0)
+	// 16-bit output is rendered in chunks through a stack buffer, keeping the callback allocation-free.
+	float chunk[512];
+	int16_t* out = static_cast<int16_t*>(pOutput);
+	for (ma_uint32 done = 0; done < frameCount;)
 	{
-		ma_waveform_read_pcm_frames(data->waveForm, pOutput, frameCount, nullptr);
+		const ma_uint32 count = std::min<ma_uint32>(frameCount - done, 512 / channels);
+		beeper->render(chunk, count, channels);
+		ma_pcm_f32_to_s16(out + done * channels, chunk, count * channels, ma_dither_mode_none);
+		done += count;
 	}
 }
 
+// SplitMix64 for CXNN. The standard engines and distributions differ between standard libraries,
+// so an own generator keeps seeded runs (and their recorded hashes) identical on every toolchain.
+struct ChipRng
+{
+	uint64_t state { 0 };
+
+	uint8_t next()
+	{
+		const uint64_t value = StateHash::mix(state);
+		state += 0x9E3779B97F4A7C15;
+		return static_cast<uint8_t>(value >> 56);
+	}
+
+	bool operator==(const ChipRng&) const = default;
+};
+
+struct ChipState;
+
 class ChipCore
 {
 public:
 	static constexpr int SCRWidth = 64;
 	static constexpr int SCRHeight = 32;
+	using ScreenBuffer = std::bitset<SCRWidth * SCRHeight>;
 
 	int CPUfrequency { 500 };
 	bool enableSound { true };
+	bool muted { false };	// silences the beeper without changing the user's enableSound setting
+	TraceRing* trace { nullptr };
+	CoverageMap* coverage { nullptr };
+	// Receives sound on/off edges; detach it while running frames that will be rolled back.
+	Beeper* beeper { nullptr };
+
+	enum class Engine { Switch, Table };
+	Engine engine { Engine::Switch };
 
-	ChipCore()
+#ifdef CHIP8_PROFILER
+	Profiler profiler {};
+#endif
+
+	explicit ChipCore(bool withAudio = true)
 	{
 		initialize();
-		initAudio();
+		if (withAudio) configureAudio({});
+	}
+	ChipCore(const ChipCore&) = delete;
+	ChipCore& operator=(const ChipCore&) = delete;
+
+	~ChipCore()
+	{
+		shutdownAudio();
+	}
+
+	std::unique_ptr<ChipCore> clone() const
+	{
+		return std::unique_ptr<ChipCore>(new ChipCore(*this, CloneTag{}));
 	}
 
 	inline bool getPixel(uint8_t x, uint8_t y)
 	{
 		return screenBuffer[SCRWidth * y + x];
 	}
+	inline const ScreenBuffer& getScreenBuffer() const
+	{
+		return screenBuffer;
+	}
+	inline uint64_t getScreenHash() const
+	{
+		return screenHash;
+	}
+	inline uint8_t peek(uint16_t addr) const
+	{
+		return RAM.read(addr);
+	}
+	inline void poke(uint16_t addr, uint8_t val)
+	{
+		RAM.write(addr, val);
+	}
+	const PagedRAM& memory() const
+	{
+		return RAM;
+	}
+	void seed(uint32_t value)
+	{
+		rng.state = value;
+	}
 	inline void setKey(uint8_t key, bool isPressed)
 	{
 		keys[key] = isPressed;
@@ -55,36 +145,400 @@ public:
 	}
 	void setVolume(double val)
 	{
-		ma_waveform_set_amplitude(&waveform, val);
+		audioBeeper.setVolume(static_cast<float>(val));
 	}
 
-	void loadROM(const wchar_t* path)
+	struct AudioConfig
 	{
-		initialize();
+		int backend { -1 };				// an ma_backend, -1 tries each available backend in turn
+		uint32_t sampleRate { 44100 };
+		uint32_t periodFrames { 0 };	// 0 leaves the period size and count to the backend
+		uint32_t periods { 0 };
+		bool mono { false };
+		bool s16 { false };
+
+		bool operator==(const AudioConfig&) const = default;
+	};
+	struct AudioStatus
+	{
+		bool running;
+		bool nullDevice;
+		const char* backend;
+		uint32_t sampleRate;
+		uint32_t channels;
+		bool s16;
+		uint32_t periodFrames;
+		uint32_t periods;
+		double latencyMs;		// the device buffer; the beeper adds Beeper::TargetLead on top
+	};
 
-		std::ifstream ifs(path, std::ios::binary | std::ios::ate);
-		std::ifstream::pos_type pos = ifs.tellg();
+	// Reopens the audio device. If the requested one cannot be opened or started the null backend is used,
+	// which is silent but keeps the beeper's clock running. Returns false when even that fails.
+	bool configureAudio(const AudioConfig& config)
+	{
+		shutdownAudio();
+
+		ma_device_config deviceConfig = ma_device_config_init(ma_device_type_playback);
+		deviceConfig.playback.format = config.s16 ? ma_format_s16 : ma_format_f32;
+		deviceConfig.playback.channels = config.mono ? 1 : 2;
+		deviceConfig.sampleRate = config.sampleRate;
+		deviceConfig.periodSizeInFrames = config.periodFrames;
+		deviceConfig.periods = config.periods;
+		deviceConfig.noFixedSizedCallback = MA_TRUE;
+		deviceConfig.dataCallback = sound_data_callback;
+		deviceConfig.pUserData = &audioBeeper;
 
-		if (pos <= sizeof(RAM) - 0x200)
+		const ma_backend requested = static_cast<ma_backend>(config.backend);
+		ma_result result = openAudio(config.backend >= 0 ? &requested : nullptr, config.backend >= 0 ? 1 : 0, deviceConfig);
+
+		if (result != MA_SUCCESS && requested != ma_backend_null)
+		{
+			std::cout << "Failed to open audio device: " << ma_result_description(result) << ", using the null device" << std::endl;
+
+			const ma_backend fallback = ma_backend_null;
+			result = openAudio(&fallback, 1, deviceConfig);
+		}
+		if (result != MA_SUCCESS)
 		{
-			ifs.seekg(0, std::ios::beg);
-			ifs.read(reinterpret_cast<char*>(&RAM[0x200]), pos);
+			std::cout << "Failed to open null audio device: " << ma_result_description(result) << std::endl;
+			return false;
 		}
 
-		ifs.close();
+		beeper = &audioBeeper;
+		return true;
+	}
+
+	AudioStatus getAudioStatus() const
+	{
+		if (!audioInitialized)
+			return { false, false, "none", 0, 0, false, 0, 0, 0.0 };
+
+		const auto& playback = soundDevice.playback;
+		return { true, soundDevice.pContext->backend == ma_backend_null, ma_get_backend_name(soundDevice.pContext->backend),
+			soundDevice.sampleRate, playback.channels, playback.format == ma_format_s16, playback.internalPeriodSizeInFrames,
+			playback.internalPeriods, 1000.0 * playback.internalPeriodSizeInFrames * playback.internalPeriods / playback.internalSampleRate };
+	}
+
+	static constexpr size_t MaxROMSize = PagedRAM::Size - 0x200;
+
+	// The loaders leave the core untouched unless they return LoadResult::Ok.
+	// Accepts plain ROM files, .gz files and zip members addressed as archive.zip/member.ch8.
+	LoadResult loadROM(const std::filesystem::path& path)
+	{
+		uint8_t romData[MaxROMSize];
+		size_t size { 0 };
+
+		const LoadResult result = Archive::readRom(path, romData, sizeof(romData), size);
+		return result == LoadResult::Ok ? loadROM(std::span<const uint8_t>(romData, size)) : result;
 	}
+#ifndef _WIN32
+	LoadResult loadROM(int fd)
+	{
+		uint8_t romData[MaxROMSize];
+		size_t size { 0 };
+
+		const LoadResult result = Archive::readFile(fd, romData, sizeof(romData), size);
+		return result == LoadResult::Ok ? loadROM(std::span<const uint8_t>(romData, size)) : result;
+	}
+#endif
+	LoadResult loadROM(std::span<const uint8_t> rom)
+	{
+		if (rom.size() > MaxROMSize) return LoadResult::TooLarge;
+
+		initialize();
+		RAM.copyFrom(0x200, rom.data(), rom.size());
+		return LoadResult::Ok;
+	}
+
+	// Returns the core to its power-on state without touching the audio device.
+	void reset()
+	{
+		initialize();
+	}
+
+	uint64_t stateHash() const
+	{
+		uint64_t regs[2];
+		std::memcpy(regs, V, sizeof(V));
+
+		uint64_t hash = RAM.hash() ^ screenHash;
+		hash = StateHash::combine(hash, regs[0]);
+		hash = StateHash::combine(hash, regs[1]);
+		hash = StateHash::combine(hash, (static_cast<uint64_t>(I) << 48) | (static_cast<uint64_t>(pc) << 32) |
+			(static_cast<uint64_t>(sp) << 16) | (delay_timer << 8) | sound_timer);
+
+		for (uint16_t addr : stack)
+			hash = StateHash::combine(hash, addr);
+
+		return StateHash::combine(hash, (keys.to_ulong() << 8) | (inputReg != nullptr ? inputReg - V : 0xFF));
+	}
+
+	void saveState(ChipState& state) const;
+	void loadState(const ChipState& state);
 
 	void updateTimers()
 	{
 		if (delay_timer > 0) delay_timer--;
 		if (sound_timer > 0) sound_timer--;
+
+		timerTicks++;
+		tickStartCycle = cycleCount;
+		if (beeper != nullptr) beeper->advance(soundClock());
+		updateSound();
+	}
+
+	// Emulated seconds: timer ticks plus the fraction of the current tick's cycles already run.
+	double soundClock() const
+	{
+		const double cyclesPerTick = CPUfrequency / 60.0;
+		const double fraction = std::min(static_cast<double>(cycleCount - tickStartCycle), cyclesPerTick) / cyclesPerTick;
+		return (timerTicks + fraction) / 60.0;
+	}
+
+	uint64_t getCycleCount() const
+	{
+		return cycleCount;
+	}
+
+	// Runs up to count instructions and returns how many ran; stops early on a breakpoint.
+	int runCycles(int count)
+	{
+		const int features = (trace != nullptr ? Feature_Trace : 0) | (engine == Engine::Table ? Feature_TableEngine : 0) |
+			(hasBreakpoints() ? Feature_Breakpoints : 0) | (hasWatchpoints() ? Feature_Watchpoints : 0) |
+			(coverage != nullptr ? Feature_Coverage : 0);
+
+		static const auto runLoops = makeRunLoops(std::make_integer_sequence<int, Feature_All + 1>{});
+
+		stoppedAtBreakpoint = false;
+		const int executed = (this->*runLoops[features])(count);
+		resumingFromBreak = false;
+
+		return executed;
 	}
 
 	void emulateCycle()
+	{
+		runCycles(1);
+	}
+
+	inline bool hasBreakpoint(uint16_t addr) const
+	{
+		return breakpoints.test(addr & 0xFFF);
+	}
+	void setBreakpoint(uint16_t addr, bool enabled)
+	{
+		breakpoints.set(addr & 0xFFF, enabled);
+	}
+	void clearBreakpoints()
+	{
+		breakpoints.reset();
+		runToAddress = -1;
+	}
+	// Stops before the instruction at addr is executed, once. Any other stop cancels it.
+	void runTo(uint16_t addr)
+	{
+		runToAddress = addr & 0xFFF;
+	}
+	void cancelRunTo()
+	{
+		runToAddress = -1;
+	}
+	// Lets the next runCycles execute the instruction it stopped at.
+	void resume()
+	{
+		resumingFromBreak = true;
+	}
+	bool hitBreakpoint() const
+	{
+		return stoppedAtBreakpoint;
+	}
+	bool hasBreakpoints() const
+	{
+		return runToAddress >= 0 || breakpoints.any();
+	}
+
+	struct WatchHit
+	{
+		uint16_t addr;
+		uint16_t pc;
+		uint8_t oldValue;
+		uint8_t newValue;
+		bool write;
+	};
+
+	// Breaks after the instruction that reads or writes [begin, end] through FX33, FX55, FX65 or DXYN.
+	void addWatchpoint(uint16_t begin, uint16_t end, bool onRead, bool onWrite)
+	{
+		for (uint16_t addr = begin & 0xFFF; addr <= (end & 0xFFF); addr++)
+		{
+			if (onRead) readWatch.set(addr);
+			if (onWrite) writeWatch.set(addr);
+		}
+
+		watchpointsSet = readWatch.any() || writeWatch.any();
+	}
+	void clearWatchpoints()
+	{
+		readWatch.reset();
+		writeWatch.reset();
+		watchpointsSet = false;
+	}
+	bool hasWatchpoints() const
+	{
+		return watchpointsSet;
+	}
+	const WatchHit& getLastWatchHit() const
+	{
+		return lastWatchHit;
+	}
+
+	uint8_t getV(uint8_t reg) const { return V[reg & 0xF]; }
+	uint16_t getI() const { return I; }
+	uint16_t getPC() const { return pc; }
+	uint16_t getSP() const { return sp; }
+	uint16_t getStack(uint8_t level) const { return stack[level & 0xF]; }
+	uint8_t getDelayTimer() const { return delay_timer; }
+	uint8_t getSoundTimer() const { return sound_timer; }
+	bool isWaitingForKey() const { return inputReg != nullptr; }
+
+private:
+	enum Feature
+	{
+		Feature_Trace = 1,
+		Feature_TableEngine = 2,
+		Feature_Breakpoints = 4,
+		Feature_Watchpoints = 8,
+		Feature_Coverage = 16,
+		Feature_All = 31
+	};
+
+	using RunLoop = int (ChipCore::*)(int);
+
+	template <int... Features>
+	static constexpr std::array<RunLoop, sizeof...(Features)> makeRunLoops(std::integer_sequence<int, Features...>)
+	{
+		return { &ChipCore::runLoop<Features>... };
+	}
+
+	template <int Features>
+	int runLoop(int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			if constexpr ((Features & Feature_Breakpoints) != 0)
+			{
+				const bool atBreakpoint = breakpoints.test(pc & 0xFFF) || runToAddress == (pc & 0xFFF);
+
+				if (atBreakpoint && !(i == 0 && resumingFromBreak))
+				{
+					runToAddress = -1;
+					stoppedAtBreakpoint = true;
+					return i;
+				}
+			}
+
+			executeCycle<Features>();
+
+			if constexpr ((Features & Feature_Watchpoints) != 0)
+			{
+				if (watchTriggered)
+				{
+					watchTriggered = false;
+					runToAddress = -1;
+					stoppedAtBreakpoint = true;
+					return i + 1;
+				}
+			}
+		}
+
+		return count;
+	}
+
+	template <int Features>
+	inline void executeCycle()
 	{
 		if (inputReg != nullptr) return;
 
-		const uint16_t opcode = (RAM[pc & 0xFFF] << 8) | RAM[(pc + 1) & 0xFFF];
+		const uint16_t opcodePC = pc;
+		const uint16_t opcode = (RAM.read(pc) << 8) | RAM.read(pc + 1);
+
+#ifdef CHIP8_PROFILER
+		if (profiler.enabled)
+		{
+			profiler.pcCounts[pc & 0xFFF]++;
+			profiler.opcodeCounts[opcode >> 12]++;
+		}
+#endif
+
+		if constexpr ((Features & Feature_Coverage) != 0)
+		{
+			coverage->mark(pc, Coverage_Executed);
+			coverage->mark(pc + 1, Coverage_Executed);
+		}
+
+		if constexpr ((Features & Feature_TableEngine) != 0)
+			(this->*opcodeTable<Features>[opcode >> 12])(opcode);
+		else
+			interpret<Features>(opcode);
+
+		if constexpr ((Features & Feature_Watchpoints) != 0)
+		{
+			if (watchTriggered) lastWatchHit.pc = opcodePC;
+		}
+
+		if constexpr ((Features & Feature_Trace) != 0)
+		{
+			const uint8_t xOperand = (opcode & 0x0F00) >> 8;
+			trace->push({ cycleCount, opcodePC, opcode, I, xOperand, V[xOperand] });
+		}
+
+		cycleCount++;
+	}
+
+	// Data accesses made by instructions (FX33, FX55, FX65 and DXYN sprite rows).
+	// Without Feature_Watchpoints and Feature_Coverage these are plain RAM accesses.
+	template <int Features>
+	inline uint8_t readData(uint16_t addr, CoverageFlags access)
+	{
+		const uint8_t val = RAM.read(addr);
+
+		if constexpr ((Features & Feature_Coverage) != 0)
+			coverage->mark(addr, access);
+
+		if constexpr ((Features & Feature_Watchpoints) != 0)
+		{
+			if (readWatch.test(addr & 0xFFF))
+				onWatchpoint(addr, val, val, false);
+		}
+
+		return val;
+	}
+	template <int Features>
+	inline void writeData(uint16_t addr, uint8_t val)
+	{
+		if constexpr ((Features & Feature_Coverage) != 0)
+			coverage->mark(addr, Coverage_Written);
+
+		if constexpr ((Features & Feature_Watchpoints) != 0)
+		{
+			if (writeWatch.test(addr & 0xFFF))
+				onWatchpoint(addr, RAM.read(addr), val, true);
+		}
+
+		RAM.write(addr, val);
+	}
+	void onWatchpoint(uint16_t addr, uint8_t oldValue, uint8_t newValue, bool write)
+	{
+		if (watchTriggered) return;
+
+		lastWatchHit = { static_cast<uint16_t>(addr & 0xFFF), 0, oldValue, newValue, write };
+		watchTriggered = true;
+	}
+
+	// Reference interpreter, every other engine must match it exactly.
+	template <int Features>
+	void interpret(uint16_t opcode)
+	{
 		bool incrementCounter { true };
 
 		const uint8_t xOperand = (opcode & 0x0F00) >> 8;
@@ -211,11 +665,23 @@ public:
 			incrementCounter = false;
 			break;
 		case 0xC000:
-			regX = rngDistr(rngEng) & doubleNibble;
+			regX = rng.next() & doubleNibble;
 			break;
 		case 0xD000: 
-			drawSprite(regX % SCRWidth, regY % SCRHeight, opcode & 0x000F);
+		{
+#ifdef CHIP8_PROFILER
+			const auto drawStart = std::chrono::steady_clock::now();
+#endif
+			drawSprite<Features>(regX % SCRWidth, regY % SCRHeight, opcode & 0x000F);
+#ifdef CHIP8_PROFILER
+			if (profiler.enabled)
+			{
+				profiler.drawCalls++;
+				profiler.drawNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - drawStart).count();
+			}
+#endif
 			break;
+		}
 		case 0xE000:
 			switch (opcode & 0x00FF)
 			{
@@ -244,24 +710,25 @@ public:
 				break;
 			case 0x0018:
 				sound_timer = regX;
+				updateSound();
 				break;
 			case 0x0029:
 				I = (regX & 0xF) * 0x5;
 				break;
 			case 0x0033:
-				RAM[I & 0xFFF] = regX / 100;
-				RAM[(I + 1) & 0xFFF] = (regX / 10) % 10;
-				RAM[(I + 2) & 0xFFF] = (regX % 100) % 10;
+				writeData<Features>(I, regX / 100);
+				writeData<Features>(I + 1, (regX / 10) % 10);
+				writeData<Features>(I + 2, (regX % 100) % 10);
 				break;
 			case 0x0055:
 				for (int i = 0; i <= (xOperand & 0xF); i++)
-					RAM[(I + i) & 0xFFF] = V[i];
+					writeData<Features>(I + i, V[i]);
 
 				if (Quirks::MemoryIncrement) I += xOperand + 1;
 				break;
 			case 0x0065:
 				for (int i = 0; i <= (xOperand & 0xF); i++) 
-					V[i] = RAM[(I + i) & 0xFFF];
+					V[i] = readData<Features>(I + i, Coverage_Load);
 
 				if (Quirks::MemoryIncrement) I += xOperand + 1;
 				break;
@@ -273,9 +740,172 @@ public:
 			pc += 2;
 	}
 
-private:
-	std::bitset<SCRWidth * SCRHeight> screenBuffer{};
-	uint8_t RAM[4096];
+	// Table dispatch engine: one handler per high nibble, each responsible for advancing pc.
+	using OpcodeHandler = void (ChipCore::*)(uint16_t);
+
+	static constexpr uint8_t opX(uint16_t opcode) { return (opcode >> 8) & 0xF; }
+	static constexpr uint8_t opY(uint16_t opcode) { return (opcode >> 4) & 0xF; }
+
+	void opSystem(uint16_t opcode)
+	{
+		if (opcode == 0x00E0) clearScreen();
+		else if (opcode == 0x00EE) pc = stack[(--sp) & 0xF];
+		pc += 2;
+	}
+	void opJump(uint16_t opcode)
+	{
+		pc = opcode & 0x0FFF;
+	}
+	void opCall(uint16_t opcode)
+	{
+		stack[(sp++) & 0xF] = pc;
+		pc = opcode & 0x0FFF;
+	}
+	void opSkipEqualImm(uint16_t opcode)
+	{
+		pc += V[opX(opcode)] == (opcode & 0xFF) ? 4 : 2;
+	}
+	void opSkipNotEqualImm(uint16_t opcode)
+	{
+		pc += V[opX(opcode)] != (opcode & 0xFF) ? 4 : 2;
+	}
+	void opSkipEqualReg(uint16_t opcode)
+	{
+		pc += (opcode & 0xF) == 0 && V[opX(opcode)] == V[opY(opcode)] ? 4 : 2;
+	}
+	void opLoadImm(uint16_t opcode)
+	{
+		V[opX(opcode)] = opcode & 0xFF;
+		pc += 2;
+	}
+	void opAddImm(uint16_t opcode)
+	{
+		V[opX(opcode)] += opcode & 0xFF;
+		pc += 2;
+	}
+	void opArithmetic(uint16_t opcode)
+	{
+		uint8_t& regX = V[opX(opcode)];
+		const uint8_t x = regX;
+		const uint8_t y = V[opY(opcode)];
+
+		switch (opcode & 0xF)
+		{
+		case 0x0: regX = y; break;
+		case 0x1: regX = x | y; if (Quirks::VFReset) V[0xF] = 0; break;
+		case 0x2: regX = x & y; if (Quirks::VFReset) V[0xF] = 0; break;
+		case 0x3: regX = x ^ y; if (Quirks::VFReset) V[0xF] = 0; break;
+		case 0x4: regX = x + y; V[0xF] = x + y > 255; break;
+		case 0x5: regX = x - y; V[0xF] = x >= y; break;
+		case 0x6:
+		{
+			const uint8_t src = Quirks::Shifting ? x : y;
+			regX = src >> 1;
+			V[0xF] = src & 1;
+			break;
+		}
+		case 0x7: regX = y - x; V[0xF] = y >= x; break;
+		case 0xE:
+		{
+			const uint8_t src = Quirks::Shifting ? x : y;
+			regX = src << 1;
+			V[0xF] = src >> 7;
+			break;
+		}
+		}
+
+		pc += 2;
+	}
+	void opSkipNotEqualReg(uint16_t opcode)
+	{
+		pc += (opcode & 0xF) == 0 && V[opX(opcode)] != V[opY(opcode)] ? 4 : 2;
+	}
+	void opLoadIndex(uint16_t opcode)
+	{
+		I = opcode & 0x0FFF;
+		pc += 2;
+	}
+	void opJumpOffset(uint16_t opcode)
+	{
+		pc = (Quirks::Jumping ? V[opX(opcode)] : V[0]) + (opcode & 0x0FFF);
+	}
+	void opRandom(uint16_t opcode)
+	{
+		V[opX(opcode)] = rng.next() & opcode & 0xFF;
+		pc += 2;
+	}
+	template <int Features>
+	void opDraw(uint16_t opcode)
+	{
+#ifdef CHIP8_PROFILER
+		const auto drawStart = std::chrono::steady_clock::now();
+#endif
+		drawSprite<Features>(V[opX(opcode)] % SCRWidth, V[opY(opcode)] % SCRHeight, opcode & 0xF);
+#ifdef CHIP8_PROFILER
+		if (profiler.enabled)
+		{
+			profiler.drawCalls++;
+			profiler.drawNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - drawStart).count();
+		}
+#endif
+		pc += 2;
+	}
+	void opSkipKey(uint16_t opcode)
+	{
+		const bool pressed = keys[V[opX(opcode)] & 0xF];
+
+		if ((opcode & 0xFF) == 0x9E) pc += pressed ? 4 : 2;
+		else if ((opcode & 0xFF) == 0xA1) pc += pressed ? 2 : 4;
+		else pc += 2;
+	}
+	template <int Features>
+	void opMisc(uint16_t opcode)
+	{
+		const uint8_t x = opX(opcode);
+		uint8_t& regX = V[x];
+
+		switch (opcode & 0xFF)
+		{
+		case 0x07: regX = delay_timer; break;
+		case 0x0A: inputReg = &regX; break;
+		case 0x15: delay_timer = regX; break;
+		case 0x18: sound_timer = regX; updateSound(); break;
+		case 0x1E: I += regX; break;
+		case 0x29: I = (regX & 0xF) * 0x5; break;
+		case 0x33:
+			writeData<Features>(I, regX / 100);
+			writeData<Features>(I + 1, (regX / 10) % 10);
+			writeData<Features>(I + 2, regX % 10);
+			break;
+		case 0x55:
+			for (int i = 0; i <= x; i++)
+				writeData<Features>(I + i, V[i]);
+
+			if (Quirks::MemoryIncrement) I += x + 1;
+			break;
+		case 0x65:
+			for (int i = 0; i <= x; i++)
+				V[i] = readData<Features>(I + i, Coverage_Load);
+
+			if (Quirks::MemoryIncrement) I += x + 1;
+			break;
+		}
+
+		pc += 2;
+	}
+
+	template <int Features>
+	static constexpr OpcodeHandler opcodeTable[16] =
+	{
+		&ChipCore::opSystem, &ChipCore::opJump, &ChipCore::opCall, &ChipCore::opSkipEqualImm,
+		&ChipCore::opSkipNotEqualImm, &ChipCore::opSkipEqualReg, &ChipCore::opLoadImm, &ChipCore::opAddImm,
+		&ChipCore::opArithmetic, &ChipCore::opSkipNotEqualReg, &ChipCore::opLoadIndex, &ChipCore::opJumpOffset,
+		&ChipCore::opRandom, &ChipCore::opDraw<Features>, &ChipCore::opSkipKey, &ChipCore::opMisc<Features>
+	};
+
+	ScreenBuffer screenBuffer{};
+	uint64_t screenHash { 0 };
+	PagedRAM RAM;
 
 	uint8_t V[16];
 	uint16_t I;
@@ -287,11 +917,25 @@ private:
 	uint16_t stack[16];
 	uint16_t sp;
 
+	uint64_t cycleCount { 0 };
+	uint64_t timerTicks { 0 };
+	uint64_t tickStartCycle { 0 };
+
+	std::bitset<4096> breakpoints{};
+	int runToAddress { -1 };
+	bool resumingFromBreak { false };
+	bool stoppedAtBreakpoint { false };
+
+	std::bitset<4096> readWatch{};
+	std::bitset<4096> writeWatch{};
+	bool watchpointsSet { false };
+	bool watchTriggered { false };
+	WatchHit lastWatchHit {};
+
 	std::bitset<16> keys{};
 	uint8_t* inputReg;
 
-	std::default_random_engine rngEng { std::random_device{}() };
-	std::uniform_int_distribution<> rngDistr { 0, 255 };
+	ChipRng rng { std::random_device{}() };
 
 	static constexpr uint8_t fontset[80] =
 	{
@@ -314,40 +958,73 @@ private:
 	};
 
 	ma_device soundDevice;
-	ma_waveform waveform;
-	soundData sound_data { &waveform, sound_timer, enableSound };
+	Beeper audioBeeper;
+	bool audioInitialized { false };
+	bool soundGate { false };
 
-	void initAudio()
+	ma_result openAudio(const ma_backend* backends, ma_uint32 backendCount, const ma_device_config& deviceConfig)
 	{
-		constexpr double initialVolume = 0.5;
-		constexpr int frequency = 440;
+		ma_result result = ma_device_init_ex(backends, backendCount, nullptr, &deviceConfig, &soundDevice);
+		if (result != MA_SUCCESS)
+			return result;
 
-		ma_waveform_config config;
-		ma_device_config deviceConfig;
+		audioBeeper.setSampleRate(soundDevice.sampleRate);
+		result = ma_device_start(&soundDevice);
+		if (result != MA_SUCCESS)
+		{
+			ma_device_uninit(&soundDevice);
+			return result;
+		}
 
-		config = ma_waveform_config_init(ma_format_f32, 2, 44100, ma_waveform_type_square, initialVolume, frequency);
-		ma_waveform_init(&config, &waveform);
+		audioInitialized = true;
+		return MA_SUCCESS;
+	}
+	void shutdownAudio()
+	{
+		if (!audioInitialized)
+			return;
 
-		deviceConfig = ma_device_config_init(ma_device_type_playback);
-		deviceConfig.playback.format = ma_format_f32;
-		deviceConfig.playback.channels = 2;
-		deviceConfig.sampleRate = 44100;
-		deviceConfig.dataCallback = sound_data_callback;
-		deviceConfig.pUserData = &sound_data;
+		ma_device_uninit(&soundDevice);
+		audioInitialized = false;
+		beeper = nullptr;
+	}
+
+	// Sends an edge to the beeper whenever the audible state changes.
+	void updateSound()
+	{
+		const bool gate = sound_timer > 0 && enableSound && !muted;
+		if (beeper == nullptr || gate == soundGate)
+			return;
 
-		ma_device_init(NULL, &deviceConfig, &soundDevice);
-		ma_device_start(&soundDevice);
+		beeper->push(soundClock(), gate);
+		soundGate = gate;
+	}
+
+	struct CloneTag {};
+
+	ChipCore(const ChipCore& other, CloneTag) : CPUfrequency(other.CPUfrequency), enableSound(other.enableSound),
+		screenBuffer(other.screenBuffer), screenHash(other.screenHash), RAM(other.RAM), I(other.I), pc(other.pc),
+		delay_timer(other.delay_timer), sound_timer(other.sound_timer), sp(other.sp),
+		cycleCount(other.cycleCount), timerTicks(other.timerTicks), tickStartCycle(other.tickStartCycle), keys(other.keys), rng(other.rng)
+	{
+		std::memcpy(V, other.V, sizeof(V));
+		std::memcpy(stack, other.stack, sizeof(stack));
+		inputReg = other.inputReg != nullptr ? &V[other.inputReg - other.V] : nullptr;
 	}
 
 	inline void clearScreen()
 	{
 		screenBuffer.reset();
+		screenHash = 0;
 	}
-	inline void setPixel(uint8_t x, uint8_t y, bool val)
+	inline void togglePixel(uint8_t x, uint8_t y)
 	{
-		screenBuffer[SCRWidth * y + x] = val;
+		const uint16_t index = SCRWidth * y + x;
+		screenBuffer.flip(index);
+		screenHash ^= StateHash::pixelKey(index);
 	}
 
+	template <int Features>
 	inline void drawSprite(uint8_t Xpos, uint8_t Ypos, uint8_t height)
 	{
 		constexpr uint8_t width = 8;
@@ -355,7 +1032,7 @@ private:
 
 		for (int i = 0; i < height; i++)
 		{
-			uint8_t spriteRow = RAM[I + i];
+			uint8_t spriteRow = readData<Features>(I + i, Coverage_Sprite);
 			uint8_t screenY = i + Ypos;
 
 			if (Quirks::Clipping)
@@ -381,9 +1058,8 @@ private:
 					else
 						screenX %= SCRWidth;
 
-					bool screenPixel = getPixel(screenX, screenY);
-					if (screenPixel) V[0xF] = 1;
-					setPixel(screenX, screenY, !screenPixel);
+					if (getPixel(screenX, screenY)) V[0xF] = 1;
+					togglePixel(screenX, screenY);
 				}
 			}
 		}
@@ -398,13 +1074,88 @@ private:
 		sp = 0;
 		delay_timer = 0;
 		sound_timer = 0;
+		cycleCount = 0;
+		tickStartCycle = 0;
+		updateSound();
 
 		std::memset(V, 0, sizeof(V));
-		std::memset(RAM, 0, sizeof(RAM));
-		std::memcpy(RAM, fontset, sizeof(fontset));
+		std::memset(stack, 0, sizeof(stack));
+		RAM.clear();
+		RAM.copyFrom(0, fontset, sizeof(fontset));
 
 		clearScreen();
 		keys.reset();
 		inputReg = nullptr;
 	}
-};
\ No newline at end of file
+};
+
+struct ChipState
+{
+	ChipCore::ScreenBuffer screenBuffer;
+	uint8_t RAM[4096];
+
+	uint8_t V[16];
+	uint16_t I;
+	uint16_t pc;
+
+	uint8_t delay_timer;
+	uint8_t sound_timer;
+
+	uint16_t stack[16];
+	uint16_t sp;
+
+	uint64_t cycleCount;
+	uint64_t timerTicks;
+	uint64_t tickStartCycle;
+
+	std::bitset<16> keys;
+	int8_t inputReg;
+
+	ChipRng rng;
+};
+
+inline void ChipCore::saveState(ChipState& state) const
+{
+	state.screenBuffer = screenBuffer;
+	RAM.copyTo(state.RAM);
+	std::memcpy(state.V, V, sizeof(V));
+	state.I = I;
+	state.pc = pc;
+	state.delay_timer = delay_timer;
+	state.sound_timer = sound_timer;
+	std::memcpy(state.stack, stack, sizeof(stack));
+	state.sp = sp;
+	state.cycleCount = cycleCount;
+	state.timerTicks = timerTicks;
+	state.tickStartCycle = tickStartCycle;
+	state.keys = keys;
+	state.inputReg = inputReg != nullptr ? static_cast<int8_t>(inputReg - V) : -1;
+	state.rng = rng;
+}
+
+inline void ChipCore::loadState(const ChipState& state)
+{
+	screenBuffer = state.screenBuffer;
+	screenHash = 0;
+	for (int i = 0; i < SCRWidth * SCRHeight; i++)
+	{
+		if (screenBuffer[i])
+			screenHash ^= StateHash::pixelKey(i);
+	}
+
+	RAM.copyFrom(0, state.RAM, sizeof(state.RAM));
+	std::memcpy(V, state.V, sizeof(V));
+	I = state.I;
+	pc = state.pc;
+	delay_timer = state.delay_timer;
+	sound_timer = state.sound_timer;
+	std::memcpy(stack, state.stack, sizeof(stack));
+	sp = state.sp;
+	cycleCount = state.cycleCount;
+	timerTicks = state.timerTicks;
+	tickStartCycle = state.tickStartCycle;
+	keys = state.keys;
+	inputReg = state.inputReg >= 0 ? &V[state.inputReg & 0xF] : nullptr;
+	rng = state.rng;
+	updateSound();
+}
\ No newline at end of file
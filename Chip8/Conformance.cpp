@@ -0,0 +1,192 @@
+#include "Conformance.h"
+#include "ChipCore.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// A key held down from frame `from` until it is released at frame `to`.
+struct KeyHold
+{
+    uint8_t key {};
+    int from {};
+    int to {};
+};
+
+struct ConformanceEntry
+{
+    std::string rom;
+    std::string profile;
+    int frames {};
+    int cyclesPerFrame {};
+    uint64_t hash {};
+    std::vector<std::pair<uint16_t, uint8_t>> pokes;
+    std::vector<KeyHold> keys;
+};
+
+static bool parseEntry(const std::string& line, ConformanceEntry& entry)
+{
+    std::stringstream ss(line);
+    std::string hash, poke;
+
+    if (!(ss >> entry.rom >> entry.profile >> entry.frames >> entry.cyclesPerFrame >> hash))
+        return false;
+
+    entry.hash = std::stoull(hash, nullptr, 16);
+
+    while (ss >> poke)
+    {
+        const size_t at = poke.find('@');
+        const size_t dash = poke.find('-', at);
+        if (at != std::string::npos && dash != std::string::npos)
+        {
+            entry.keys.push_back({ static_cast<uint8_t>(std::stoul(poke.substr(0, at), nullptr, 16) & 0xF),
+                std::stoi(poke.substr(at + 1, dash - at - 1)), std::stoi(poke.substr(dash + 1)) });
+            continue;
+        }
+
+        const size_t separator = poke.find('=');
+        if (separator == std::string::npos) return false;
+
+        entry.pokes.emplace_back(static_cast<uint16_t>(std::stoul(poke.substr(0, separator), nullptr, 16)),
+            static_cast<uint8_t>(std::stoul(poke.substr(separator + 1), nullptr, 16)));
+    }
+
+    return true;
+}
+
+static std::string formatEntry(const ConformanceEntry& entry)
+{
+    char hash[17];
+    std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(entry.hash));
+
+    std::stringstream ss;
+    ss << entry.rom << ' ' << entry.profile << ' ' << entry.frames << ' ' << entry.cyclesPerFrame << ' ' << hash;
+
+    for (const auto& [addr, val] : entry.pokes)
+        ss << ' ' << std::hex << std::uppercase << addr << '=' << static_cast<int>(val) << std::dec;
+
+    for (const KeyHold& hold : entry.keys)
+        ss << ' ' << std::hex << std::uppercase << static_cast<int>(hold.key) << std::dec << '@' << hold.from << '-' << hold.to;
+
+    return ss.str();
+}
+
+static LoadResult runEntry(ChipCore& core, const std::filesystem::path& romPath, const ConformanceEntry& entry, uint64_t& hash)
+{
+    core.coverage->clear();
+
+    const LoadResult loaded = core.loadROM(romPath);
+    if (loaded != LoadResult::Ok) return loaded;
+    core.seed(0);
+
+    for (const auto& [addr, val] : entry.pokes)
+        core.poke(addr, val);
+
+    for (int frame = 0; frame < entry.frames; frame++)
+    {
+        for (const KeyHold& hold : entry.keys)
+        {
+            if (frame == hold.from) core.setKey(hold.key, true);
+            if (frame == hold.to) core.setKey(hold.key, false);
+        }
+
+        core.updateTimers();
+        core.runCycles(entry.cyclesPerFrame);
+    }
+
+    hash = core.getScreenHash();
+    return LoadResult::Ok;
+}
+
+int runConformance(const char* manifestPath, bool record)
+{
+    std::ifstream manifest(manifestPath);
+    if (!manifest)
+    {
+        std::cout << "Failed to open conformance manifest " << manifestPath << std::endl;
+        return 1;
+    }
+
+    const std::filesystem::path baseDir = std::filesystem::path(manifestPath).parent_path();
+    std::vector<std::string> lines;
+    std::string line;
+    int passed {}, failed {};
+
+    ChipCore core { false };
+    CoverageMap coverage;
+    core.coverage = &coverage;
+
+    while (std::getline(manifest, line))
+    {
+        ConformanceEntry entry;
+
+        if (line.empty() || line[0] == '#' || !parseEntry(line, entry))
+        {
+            lines.push_back(line);
+            continue;
+        }
+
+        const Quirks::Profile* profile = Quirks::FindProfile(entry.profile);
+        if (profile == nullptr)
+        {
+            std::cout << "FAIL " << entry.rom << " [" << entry.profile << "] unknown quirk profile" << std::endl;
+            lines.push_back(line);
+            failed++;
+            continue;
+        }
+
+        Quirks::Apply(*profile);
+        uint64_t hash {};
+        const LoadResult loaded = runEntry(core, baseDir / entry.rom, entry, hash);
+
+        if (loaded != LoadResult::Ok)
+        {
+            std::cout << "FAIL " << entry.rom << " [" << entry.profile << "] " << describe(loaded) << std::endl;
+            lines.push_back(line);
+            failed++;
+            continue;
+        }
+
+        if (record)
+        {
+            entry.hash = hash;
+            lines.push_back(formatEntry(entry));
+            std::cout << "REC  " << entry.rom << " [" << entry.profile << "]" << std::endl;
+        }
+        else if (hash == entry.hash)
+        {
+            std::error_code error;
+            const uintmax_t romSize = std::filesystem::file_size(baseDir / entry.rom, error);
+            const uint16_t romEnd = static_cast<uint16_t>(error ? 0x200 : std::min<uintmax_t>(0x200 + romSize, 4096));
+            std::printf("PASS %s [%s] %d of %d ROM bytes executed\n", entry.rom.c_str(), entry.profile.c_str(),
+                coverage.count(Coverage_Executed, 0x200, romEnd), romEnd - 0x200);
+            passed++;
+        }
+        else
+        {
+            std::printf("FAIL %s [%s] expected %016llx, got %016llx\n", entry.rom.c_str(), entry.profile.c_str(),
+                static_cast<unsigned long long>(entry.hash), static_cast<unsigned long long>(hash));
+            failed++;
+        }
+    }
+
+    Quirks::Reset();
+    manifest.close();
+
+    if (record)
+    {
+        std::ofstream out(manifestPath);
+        for (const std::string& recorded : lines)
+            out << recorded << '\n';
+
+        return out.good() ? 0 : 1;
+    }
+
+    std::cout << passed << " passed, " << failed << " failed" << std::endl;
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+// Runs every ROM listed in a conformance manifest headless and compares framebuffer hashes.
+// Each manifest line is: <rom path> <quirk profile> <frames> <cycles per frame> <hash> [addr=value ...] [key@from-to ...]
+// ROM paths are relative to the manifest, addr=value pairs are hex RAM pokes applied after loading and
+// key@from-to holds a hex key down from frame `from` until frame `to`.
+// With record set, the computed hashes are written back into the manifest instead of being checked.
+int runConformance(const char* manifestPath, bool record);
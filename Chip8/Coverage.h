@@ -0,0 +1,82 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+enum CoverageFlags : uint8_t
+{
+	Coverage_Executed = 1,	// fetched as part of an instruction
+	Coverage_Sprite = 2,	// read by DXYN
+	Coverage_Load = 4,		// read by FX65
+	Coverage_Written = 8	// written by FX33 or FX55
+};
+
+// Coverage files are a CoverageFileHeader followed by one flags byte per RAM address.
+struct CoverageFileHeader
+{
+	char magic[4] { 'C', '8', 'C', 'V' };
+	uint16_t version { 1 };
+	uint16_t size { 4096 };
+};
+
+// Per-address record of how a ROM used memory, accumulated while ChipCore::coverage points at it.
+class CoverageMap
+{
+public:
+	inline void mark(uint16_t addr, uint8_t flag)
+	{
+		flags[addr & 0xFFF] |= flag;
+	}
+	uint8_t get(uint16_t addr) const
+	{
+		return flags[addr & 0xFFF];
+	}
+
+	void clear()
+	{
+		flags.fill(0);
+	}
+
+	// Number of addresses in [begin, end) with any of the given flags set.
+	int count(uint8_t flag, uint16_t begin = 0, uint16_t end = 4096) const
+	{
+		int total { 0 };
+		for (int addr = begin; addr < end && addr < 4096; addr++)
+			total += (flags[addr] & flag) != 0;
+
+		return total;
+	}
+
+	bool save(const std::filesystem::path& path) const
+	{
+		std::ofstream ofs(path, std::ios::binary);
+		if (!ofs) return false;
+
+		const CoverageFileHeader header {};
+		ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		ofs.write(reinterpret_cast<const char*>(flags.data()), flags.size());
+
+		return ofs.good();
+	}
+	// ORs a saved map into this one, so several runs of the same ROM add up.
+	bool merge(const std::filesystem::path& path)
+	{
+		std::ifstream ifs(path, std::ios::binary);
+		CoverageFileHeader header {};
+		std::array<uint8_t, 4096> saved {};
+
+		if (!ifs.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+		if (std::memcmp(header.magic, "C8CV", 4) != 0 || header.version != 1 || header.size != saved.size()) return false;
+		if (!ifs.read(reinterpret_cast<char*>(saved.data()), saved.size())) return false;
+
+		for (size_t i = 0; i < saved.size(); i++)
+			flags[i] |= saved[i];
+
+		return true;
+	}
+
+private:
+	std::array<uint8_t, 4096> flags{};
+};
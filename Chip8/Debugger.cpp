@@ -0,0 +1,243 @@
+#include "Debugger.h"
+#include "ChipCore.h"
+#include "Disassembler.h"
+
+#include "ImGui/imgui.h"
+
+#include <vector>
+
+static void continueTo(ChipCore& core, bool& paused, int addr)
+{
+    if (addr >= 0)
+        core.runTo(static_cast<uint16_t>(addr));
+    else
+        core.cancelRunTo();
+    core.resume();
+    paused = false;
+}
+
+static void renderControls(ChipCore& core, bool& paused)
+{
+    if (paused)
+    {
+        if (ImGui::Button("Continue")) continueTo(core, paused, -1);
+    }
+    else if (ImGui::Button("Break"))
+        paused = true;
+
+    ImGui::BeginDisabled(!paused);
+    ImGui::SameLine();
+    if (ImGui::Button("Step"))
+    {
+        core.resume();
+        core.runCycles(1);
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Step Over"))
+    {
+        const uint16_t pc = core.getPC();
+        if ((core.peek(pc) & 0xF0) == 0x20)
+            continueTo(core, paused, pc + 2);
+        else
+        {
+            core.resume();
+            core.runCycles(1);
+        }
+    }
+    ImGui::EndDisabled();
+
+    ImGui::SameLine();
+    if (ImGui::Button("Clear Breakpoints")) core.clearBreakpoints();
+
+    if (core.isWaitingForKey())
+    {
+        ImGui::SameLine();
+        ImGui::TextDisabled("(waiting for key)");
+    }
+}
+
+static void renderDisassembly(ChipCore& core, bool& paused)
+{
+    static uint16_t lastPC { 0xFFFF };
+    static DisassemblyCache disassembly;
+
+    const uint16_t pc = core.getPC() & 0xFFF;
+    const int base = pc & 1;
+    const int rowCount = (4096 - base) / 2;
+    const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+
+    disassembly.update(core.memory());
+
+    if (!ImGui::BeginTable("disassembly", 4, ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg))
+        return;
+
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("", ImGuiTableColumnFlags_WidthFixed, rowHeight);
+    ImGui::TableSetupColumn("Addr", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableSetupColumn("Op", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableSetupColumn("Instruction");
+    ImGui::TableHeadersRow();
+
+    if (paused && pc != lastPC)
+        ImGui::SetScrollY(std::max(0.0f, ((pc - base) / 2) * rowHeight - ImGui::GetWindowHeight() * 0.4f));
+    lastPC = paused ? pc : 0xFFFF;
+
+    ImGuiListClipper clipper;
+    clipper.Begin(rowCount, rowHeight);
+
+    while (clipper.Step())
+    {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+        {
+            const uint16_t addr = static_cast<uint16_t>(base + row * 2);
+            const uint16_t opcode = disassembly.opcode(addr);
+
+            ImGui::TableNextRow();
+            if (addr == pc)
+                ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg1, ImGui::GetColorU32(ImGuiCol_TextSelectedBg));
+
+            ImGui::PushID(addr);
+            ImGui::TableNextColumn();
+            if (ImGui::Selectable(core.hasBreakpoint(addr) ? "*" : " ", false, ImGuiSelectableFlags_None))
+                core.setBreakpoint(addr, !core.hasBreakpoint(addr));
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%03X", addr);
+            ImGui::TableNextColumn();
+            ImGui::Text("%04X", opcode);
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(disassembly.text(addr));
+
+            if (ImGui::BeginPopupContextItem("row", ImGuiPopupFlags_MouseButtonRight))
+            {
+                if (ImGui::MenuItem("Run to Cursor")) continueTo(core, paused, addr);
+                if (ImGui::MenuItem("Toggle Breakpoint")) core.setBreakpoint(addr, !core.hasBreakpoint(addr));
+                ImGui::EndPopup();
+            }
+            ImGui::PopID();
+        }
+    }
+
+    ImGui::EndTable();
+}
+
+static void renderRegisters(const ChipCore& core)
+{
+    if (ImGui::BeginTable("registers", 4, ImGuiTableFlags_Borders))
+    {
+        for (uint8_t reg = 0; reg < 16; reg++)
+        {
+            ImGui::TableNextColumn();
+            ImGui::Text("V%X %02X", reg, core.getV(reg));
+        }
+
+        ImGui::EndTable();
+    }
+
+    ImGui::Text("PC %03X   I %03X", core.getPC(), core.getI());
+    ImGui::Text("DT %02X    ST %02X", core.getDelayTimer(), core.getSoundTimer());
+    ImGui::Text("Cycles %llu", static_cast<unsigned long long>(core.getCycleCount()));
+
+    ImGui::SeparatorText("Stack");
+    ImGui::Text("SP %X", core.getSP());
+
+    for (int level = std::min<int>(core.getSP(), 16) - 1; level >= 0; level--)
+        ImGui::Text("%X: %03X", level, core.getStack(level));
+}
+
+static void renderWatchpoints(ChipCore& core)
+{
+    struct Watchpoint
+    {
+        uint16_t begin;
+        uint16_t end;
+        bool onRead;
+        bool onWrite;
+    };
+    static std::vector<Watchpoint> watchpoints;
+    static uint16_t begin { 0x200 };
+    static uint16_t end { 0x200 };
+    static bool onRead { false };
+    static bool onWrite { true };
+
+    ImGui::SeparatorText("Watchpoints");
+
+    const uint16_t step = 1;
+    ImGui::SetNextItemWidth(ImGui::CalcTextSize("0000").x * 3);
+    ImGui::InputScalar("##begin", ImGuiDataType_U16, &begin, &step, nullptr, "%03X", ImGuiInputTextFlags_CharsHexadecimal);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(ImGui::CalcTextSize("0000").x * 3);
+    ImGui::InputScalar("##end", ImGuiDataType_U16, &end, &step, nullptr, "%03X", ImGuiInputTextFlags_CharsHexadecimal);
+    begin &= 0xFFF;
+    end &= 0xFFF;
+
+    ImGui::Checkbox("R", &onRead);
+    ImGui::SameLine();
+    ImGui::Checkbox("W", &onWrite);
+    ImGui::SameLine();
+    ImGui::BeginDisabled(!onRead && !onWrite);
+    if (ImGui::Button("Add"))
+    {
+        watchpoints.push_back({ std::min(begin, end), std::max(begin, end), onRead, onWrite });
+        core.addWatchpoint(watchpoints.back().begin, watchpoints.back().end, onRead, onWrite);
+    }
+    ImGui::EndDisabled();
+
+    // The core only keeps the combined address bitmaps, so removing one range rebuilds them.
+    if (!core.hasWatchpoints()) watchpoints.clear();
+    int removed { -1 };
+
+    for (int i = 0; i < static_cast<int>(watchpoints.size()); i++)
+    {
+        const Watchpoint& watch = watchpoints[i];
+
+        ImGui::PushID(i);
+        if (ImGui::SmallButton("x")) removed = i;
+        ImGui::SameLine();
+        ImGui::Text("%03X-%03X %s%s", watch.begin, watch.end, watch.onRead ? "R" : "", watch.onWrite ? "W" : "");
+        ImGui::PopID();
+    }
+
+    if (removed >= 0)
+    {
+        watchpoints.erase(watchpoints.begin() + removed);
+        core.clearWatchpoints();
+
+        for (const Watchpoint& watch : watchpoints)
+            core.addWatchpoint(watch.begin, watch.end, watch.onRead, watch.onWrite);
+    }
+
+    const ChipCore::WatchHit& hit = core.getLastWatchHit();
+    if (core.hasWatchpoints() && hit.pc != 0)
+    {
+        if (hit.write)
+            ImGui::Text("Last: %03X wrote %03X (%02X -> %02X)", hit.pc, hit.addr, hit.oldValue, hit.newValue);
+        else
+            ImGui::Text("Last: %03X read %03X (%02X)", hit.pc, hit.addr, hit.oldValue);
+    }
+}
+
+void renderDebuggerWindow(ChipCore& core, bool& paused, bool* open)
+{
+    if (!ImGui::Begin("Debugger", open))
+    {
+        ImGui::End();
+        return;
+    }
+
+    renderControls(core, paused);
+    ImGui::Separator();
+
+    ImGui::BeginChild("disassemblyPane", ImVec2(ImGui::GetContentRegionAvail().x * 0.6f, 0));
+    renderDisassembly(core, paused);
+    ImGui::EndChild();
+
+    ImGui::SameLine();
+    ImGui::BeginChild("registerPane");
+    renderRegisters(core);
+    renderWatchpoints(core);
+    ImGui::EndChild();
+
+    ImGui::End();
+}
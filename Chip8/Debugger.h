@@ -0,0 +1,7 @@
+#pragma once
+
+class ChipCore;
+
+// Disassembly, register, stack and timer panes with step, step over and run to cursor.
+// paused is the frontend's pause flag; the debugger clears it to continue and sets it to break.
+void renderDebuggerWindow(ChipCore& core, bool& paused, bool* open);
@@ -0,0 +1,152 @@
+#include "Differential.h"
+#include "ChipCore.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+static std::string describeMismatch(const ChipState& a, const ChipState& b)
+{
+    char buffer[96];
+    const auto field = [&buffer](const char* name, int index, int valA, int valB)
+    {
+        if (index >= 0) std::snprintf(buffer, sizeof(buffer), "%s[0x%X]: 0x%X vs 0x%X", name, index, valA, valB);
+        else std::snprintf(buffer, sizeof(buffer), "%s: 0x%X vs 0x%X", name, valA, valB);
+        return std::string { buffer };
+    };
+
+    if (a.pc != b.pc) return field("pc", -1, a.pc, b.pc);
+    if (a.I != b.I) return field("I", -1, a.I, b.I);
+
+    for (int i = 0; i < 16; i++)
+    {
+        if (a.V[i] != b.V[i]) return field("V", i, a.V[i], b.V[i]);
+    }
+
+    if (a.sp != b.sp) return field("sp", -1, a.sp, b.sp);
+    for (int i = 0; i < 16; i++)
+    {
+        if (a.stack[i] != b.stack[i]) return field("stack", i, a.stack[i], b.stack[i]);
+    }
+
+    if (a.delay_timer != b.delay_timer) return field("delay_timer", -1, a.delay_timer, b.delay_timer);
+    if (a.sound_timer != b.sound_timer) return field("sound_timer", -1, a.sound_timer, b.sound_timer);
+    if (a.inputReg != b.inputReg) return field("inputReg", -1, a.inputReg, b.inputReg);
+    if (a.keys != b.keys) return field("keys", -1, static_cast<int>(a.keys.to_ulong()), static_cast<int>(b.keys.to_ulong()));
+
+    for (int i = 0; i < 4096; i++)
+    {
+        if (a.RAM[i] != b.RAM[i]) return field("RAM", i, a.RAM[i], b.RAM[i]);
+    }
+
+    for (size_t i = 0; i < a.screenBuffer.size(); i++)
+    {
+        if (a.screenBuffer[i] != b.screenBuffer[i]) return field("screen", static_cast<int>(i), a.screenBuffer[i], b.screenBuffer[i]);
+    }
+
+    if (a.rng != b.rng) return "rng state";
+    return {};
+}
+
+std::optional<Divergence> runLockstep(ChipCore& reference, ChipCore& candidate, int frames, int cyclesPerFrame, int compareInterval, uint32_t seed)
+{
+    ChipState refState {}, candState {};
+    std::minstd_rand inputRng { seed };
+    uint64_t step {};
+
+    reference.seed(seed);
+    candidate.seed(seed);
+
+    for (int frame = 0; frame < frames; frame++)
+    {
+        if (inputRng() % 8 == 0)
+        {
+            const uint8_t key = inputRng() % 16;
+            const bool pressed = inputRng() % 2;
+            reference.setKey(key, pressed);
+            candidate.setKey(key, pressed);
+        }
+
+        reference.updateTimers();
+        candidate.updateTimers();
+
+        for (int done = 0; done < cyclesPerFrame; done += compareInterval)
+        {
+            const int chunk = std::min(compareInterval, cyclesPerFrame - done);
+
+            reference.saveState(refState);
+            candidate.saveState(candState);
+
+            reference.runCycles(chunk);
+            candidate.runCycles(chunk);
+
+            ChipState refAfter {}, candAfter {};
+            reference.saveState(refAfter);
+            candidate.saveState(candAfter);
+
+            if (describeMismatch(refAfter, candAfter).empty())
+            {
+                step += chunk;
+                continue;
+            }
+
+            reference.loadState(refState);
+            candidate.loadState(candState);
+
+            for (int i = 0; i < chunk; i++, step++)
+            {
+                const uint16_t pc = refState.pc;
+                const uint16_t opcode = (reference.peek(pc) << 8) | reference.peek(pc + 1);
+
+                reference.runCycles(1);
+                candidate.runCycles(1);
+                reference.saveState(refState);
+                candidate.saveState(candState);
+
+                const std::string field = describeMismatch(refState, candState);
+                if (!field.empty())
+                    return Divergence { step, pc, opcode, field };
+            }
+        }
+    }
+
+    return std::nullopt;
+}
+
+int runDifferential(const char* romPath, int frames, int compareInterval)
+{
+    ChipCore reference { false };
+    ChipCore candidate { false };
+    candidate.engine = ChipCore::Engine::Table;
+
+    const LoadResult loaded = reference.loadROM(romPath);
+    if (loaded != LoadResult::Ok)
+    {
+        std::cout << "Failed to load " << romPath << ": " << describe(loaded) << std::endl;
+        return 1;
+    }
+
+    int diverged {};
+
+    for (const Quirks::Profile& profile : Quirks::Profiles)
+    {
+        Quirks::Apply(profile);
+        reference.loadROM(romPath);
+        candidate.loadROM(romPath);
+
+        const auto divergence = runLockstep(reference, candidate, frames, reference.CPUfrequency / 60, compareInterval, 0);
+
+        if (divergence)
+        {
+            std::printf("DIVERGED [%s] at step %llu, pc 0x%03X, opcode %04X: %s\n", profile.name,
+                static_cast<unsigned long long>(divergence->step), divergence->pc, divergence->opcode, divergence->field.c_str());
+            diverged++;
+        }
+        else
+            std::cout << "MATCH [" << profile.name << "]" << std::endl;
+    }
+
+    Quirks::Reset();
+    return diverged > 0 ? 1 : 0;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+
+class ChipCore;
+
+struct Divergence
+{
+	uint64_t step;		// instructions executed before the mismatching one
+	uint16_t pc;		// address of the mismatching instruction
+	uint16_t opcode;
+	std::string field;	// first differing field, with both values
+};
+
+// Runs two loaded cores in lockstep with identical pseudo-random key input and compares
+// their full state every compareInterval instructions. On a mismatch both cores are rewound to
+// the last matching state and single-stepped to find the first instruction that diverged.
+std::optional<Divergence> runLockstep(ChipCore& reference, ChipCore& candidate, int frames, int cyclesPerFrame, int compareInterval, uint32_t seed);
+
+// Runs a ROM on the reference and table engines under every quirk profile and reports divergences.
+int runDifferential(const char* romPath, int frames, int compareInterval);
@@ -0,0 +1,139 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include "PagedRAM.h"
+
+// Formats one opcode as a Cowgod-style mnemonic, e.g. "LD V1, 0x20" or "DRW V0, V1, 5".
+inline void disassemble(uint16_t opcode, char* out, size_t size)
+{
+	const unsigned x = (opcode >> 8) & 0xF;
+	const unsigned y = (opcode >> 4) & 0xF;
+	const unsigned n = opcode & 0xF;
+	const unsigned nn = opcode & 0xFF;
+	const unsigned nnn = opcode & 0xFFF;
+
+	switch (opcode & 0xF000)
+	{
+	case 0x0000:
+		if (opcode == 0x00E0) std::snprintf(out, size, "CLS");
+		else if (opcode == 0x00EE) std::snprintf(out, size, "RET");
+		else std::snprintf(out, size, "SYS 0x%03X", nnn);
+		return;
+	case 0x1000: std::snprintf(out, size, "JP 0x%03X", nnn); return;
+	case 0x2000: std::snprintf(out, size, "CALL 0x%03X", nnn); return;
+	case 0x3000: std::snprintf(out, size, "SE V%X, 0x%02X", x, nn); return;
+	case 0x4000: std::snprintf(out, size, "SNE V%X, 0x%02X", x, nn); return;
+	case 0x5000:
+		if (n == 0) { std::snprintf(out, size, "SE V%X, V%X", x, y); return; }
+		break;
+	case 0x6000: std::snprintf(out, size, "LD V%X, 0x%02X", x, nn); return;
+	case 0x7000: std::snprintf(out, size, "ADD V%X, 0x%02X", x, nn); return;
+	case 0x8000:
+	{
+		static constexpr const char* arithmetic[16] =
+		{
+			"LD", "OR", "AND", "XOR", "ADD", "SUB", "SHR", "SUBN",
+			nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, "SHL", nullptr
+		};
+
+		if (arithmetic[n] != nullptr) { std::snprintf(out, size, "%s V%X, V%X", arithmetic[n], x, y); return; }
+		break;
+	}
+	case 0x9000:
+		if (n == 0) { std::snprintf(out, size, "SNE V%X, V%X", x, y); return; }
+		break;
+	case 0xA000: std::snprintf(out, size, "LD I, 0x%03X", nnn); return;
+	case 0xB000: std::snprintf(out, size, "JP V0, 0x%03X", nnn); return;
+	case 0xC000: std::snprintf(out, size, "RND V%X, 0x%02X", x, nn); return;
+	case 0xD000: std::snprintf(out, size, "DRW V%X, V%X, %u", x, y, n); return;
+	case 0xE000:
+		if (nn == 0x9E) { std::snprintf(out, size, "SKP V%X", x); return; }
+		if (nn == 0xA1) { std::snprintf(out, size, "SKNP V%X", x); return; }
+		break;
+	case 0xF000:
+		switch (nn)
+		{
+		case 0x07: std::snprintf(out, size, "LD V%X, DT", x); return;
+		case 0x0A: std::snprintf(out, size, "LD V%X, K", x); return;
+		case 0x15: std::snprintf(out, size, "LD DT, V%X", x); return;
+		case 0x18: std::snprintf(out, size, "LD ST, V%X", x); return;
+		case 0x1E: std::snprintf(out, size, "ADD I, V%X", x); return;
+		case 0x29: std::snprintf(out, size, "LD F, V%X", x); return;
+		case 0x33: std::snprintf(out, size, "LD B, V%X", x); return;
+		case 0x55: std::snprintf(out, size, "LD [I], V%X", x); return;
+		case 0x65: std::snprintf(out, size, "LD V%X, [I]", x); return;
+		}
+		break;
+	}
+
+	std::snprintf(out, size, "DW 0x%04X", opcode);
+}
+
+// Mnemonics for every address of a PagedRAM, kept in sync incrementally.
+// update() only revisits pages whose version changed and only reformats the words whose bytes differ.
+class DisassemblyCache
+{
+public:
+	static constexpr size_t TextSize = 24;
+
+	// Returns the number of words that were re-disassembled.
+	int update(const PagedRAM& ram)
+	{
+		if (&ram != source)
+		{
+			source = &ram;
+			versions.fill(UINT32_MAX);
+			for (Line& line : lines)
+				line.valid = false;
+		}
+
+		int changed { 0 };
+		for (int page = 0; page < PagedRAM::PageCount; page++)
+		{
+			if (versions[page] == ram.version(page))
+				continue;
+
+			versions[page] = ram.version(page);
+
+			// The word starting on the last byte of the previous page also reads this page,
+			// which for page 0 is the word at 0xFFF that wraps around.
+			for (int i = page * PagedRAM::PageSize - 1; i < (page + 1) * PagedRAM::PageSize; i++)
+			{
+				const uint16_t addr = i & 0xFFF;
+				Line& line = lines[addr];
+				const uint16_t opcode = (ram.read(addr) << 8) | ram.read((addr + 1) & 0xFFF);
+				if (line.valid && line.opcode == opcode)
+					continue;
+
+				disassemble(opcode, line.text, TextSize);
+				line.opcode = opcode;
+				line.valid = true;
+				changed++;
+			}
+		}
+
+		return changed;
+	}
+
+	const char* text(uint16_t addr) const
+	{
+		return lines[addr & 0xFFF].text;
+	}
+	uint16_t opcode(uint16_t addr) const
+	{
+		return lines[addr & 0xFFF].opcode;
+	}
+
+private:
+	struct Line
+	{
+		uint16_t opcode;
+		bool valid;
+		char text[TextSize];
+	};
+
+	std::array<Line, PagedRAM::Size> lines{};
+	std::array<uint32_t, PagedRAM::PageCount> versions{};
+	const PagedRAM* source { nullptr };
+};
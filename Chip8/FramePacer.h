@@ -0,0 +1,95 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#ifdef _WIN32
+// Raises the system timer resolution to 1 ms while a pacer exists, so sleeps wake close to their target.
+extern "C" __declspec(dllimport) unsigned int __stdcall timeBeginPeriod(unsigned int period);
+extern "C" __declspec(dllimport) unsigned int __stdcall timeEndPeriod(unsigned int period);
+#pragma comment(lib, "winmm.lib")
+#endif
+
+// Paces a fixed tick rate against absolute deadlines. Each wait sleeps until shortly before the
+// deadline and spins the remainder; the spin margin adapts to how late the OS wakes the thread,
+// up to MaxSpinMargin, beyond which a late wakeup is accepted rather than burning more CPU.
+// Deadlines advance by exactly one period, so late ticks are caught up instead of drifting.
+class FramePacer
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	// Falling further behind than this restarts the schedule from now instead of bursting to catch up.
+	static constexpr int MaxLagTicks = 4;
+	static constexpr clock::duration MinSpinMargin = std::chrono::microseconds(100);
+	static constexpr clock::duration MaxSpinMargin = std::chrono::microseconds(500);
+
+	FramePacer()
+	{
+#ifdef _WIN32
+		timeBeginPeriod(1);
+#endif
+	}
+	~FramePacer()
+	{
+#ifdef _WIN32
+		timeEndPeriod(1);
+#endif
+	}
+	FramePacer(const FramePacer&) = delete;
+	FramePacer& operator=(const FramePacer&) = delete;
+
+	void setRate(double ticksPerSecond)
+	{
+		period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / ticksPerSecond));
+	}
+
+	// Starts the schedule again from now, for when something else (a vsync'd swap) has set the pace.
+	void restart()
+	{
+		started = false;
+	}
+
+	void wait()
+	{
+		const clock::time_point now = clock::now();
+		if (!started)
+		{
+			next = now;
+			started = true;
+		}
+
+		next += period;
+		if (now > next + period * MaxLagTicks)
+		{
+			next = now;
+			droppedTicks++;
+			return;
+		}
+
+		if (next - now > spinMargin)
+		{
+			const clock::time_point wakeTarget = next - spinMargin;
+			std::this_thread::sleep_until(wakeTarget);
+
+			// Grow the margin right away when a wakeup comes late, shrink it slowly otherwise.
+			const auto oversleep = clock::now() - wakeTarget;
+			spinMargin = std::clamp<clock::duration>(std::max<clock::duration>(oversleep + oversleep / 4, spinMargin - spinMargin / 64),
+				MinSpinMargin, MaxSpinMargin);
+		}
+
+		while (clock::now() < next)
+			std::this_thread::yield();
+	}
+
+	uint64_t getDroppedTicks() const { return droppedTicks; }
+	double getSpinMarginMs() const { return std::chrono::duration<double, std::milli>(spinMargin).count(); }
+
+private:
+	clock::duration period { std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / 60)) };
+	clock::duration spinMargin { MaxSpinMargin };
+	clock::time_point next {};
+	bool started { false };
+	uint64_t droppedTicks { 0 };
+};
@@ -0,0 +1,131 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+
+// Rolling per-phase timings of the frontend loop, in milliseconds.
+class FrameStats
+{
+public:
+	enum Phase { CPU, Draw, ImGUI, Swap, Frame, PhaseCount };
+	static constexpr int SampleCount = 240;
+	static constexpr const char* phaseNames[PhaseCount] = { "CPU", "Draw", "ImGUI", "Swap", "Frame" };
+
+	struct Summary
+	{
+		double mean;
+		double p99;
+		double max;
+	};
+
+	inline void begin(Phase phase)
+	{
+		phaseStart[phase] = clock::now();
+	}
+	// Phases timed more than once in a frame add up.
+	inline void end(Phase phase)
+	{
+		samples[phase][cursor] += std::chrono::duration<float, std::milli>(clock::now() - phaseStart[phase]).count();
+	}
+
+	// Closes the current frame and starts recording the next one.
+	void nextFrame()
+	{
+		const auto now = clock::now();
+		if (started)
+		{
+			samples[Frame][cursor] = std::chrono::duration<float, std::milli>(now - phaseStart[Frame]).count();
+			cursor = (cursor + 1) % SampleCount;
+			completedFrames++;
+
+			for (int phase = 0; phase < PhaseCount; phase++)
+				samples[phase][cursor] = 0.0f;
+		}
+
+		started = true;
+		phaseStart[Frame] = now;
+	}
+
+	// Number of completed frames in the window, the frame in progress is excluded.
+	int size() const
+	{
+		return static_cast<int>(std::min<uint64_t>(completedFrames, SampleCount - 1));
+	}
+	// Completed frame samples, oldest first.
+	float sample(Phase phase, int index) const
+	{
+		return samples[phase][(offset() + index) % SampleCount];
+	}
+
+	Summary summary(Phase phase) const
+	{
+		const int count = size();
+		if (count == 0) return {};
+
+		std::array<float, SampleCount> sorted;
+		for (int i = 0; i < count; i++)
+			sorted[i] = sample(phase, i);
+
+		std::sort(sorted.begin(), sorted.begin() + count);
+
+		double sum{};
+		for (int i = 0; i < count; i++)
+			sum += sorted[i];
+
+		return { sum / count, sorted[(count - 1) * 99 / 100], sorted[count - 1] };
+	}
+
+	bool dumpCSV(const char* path) const
+	{
+		std::ofstream ofs(path);
+		if (!ofs) return false;
+
+		for (int phase = 0; phase < PhaseCount; phase++)
+			ofs << phaseNames[phase] << (phase + 1 < PhaseCount ? "," : "\n");
+
+		for (int i = 0; i < size(); i++)
+		{
+			for (int phase = 0; phase < PhaseCount; phase++)
+				ofs << sample(static_cast<Phase>(phase), i) << (phase + 1 < PhaseCount ? "," : "\n");
+		}
+
+		return ofs.good();
+	}
+	bool dumpJSON(const char* path) const
+	{
+		std::ofstream ofs(path);
+		if (!ofs) return false;
+
+		ofs << "{\n";
+		for (int phase = 0; phase < PhaseCount; phase++)
+		{
+			const Summary stats = summary(static_cast<Phase>(phase));
+			ofs << "  \"" << phaseNames[phase] << "\": { \"mean\": " << stats.mean << ", \"p99\": " << stats.p99
+				<< ", \"max\": " << stats.max << ", \"samples\": [";
+
+			for (int i = 0; i < size(); i++)
+				ofs << (i > 0 ? ", " : "") << sample(static_cast<Phase>(phase), i);
+
+			ofs << "] }" << (phase + 1 < PhaseCount ? ",\n" : "\n");
+		}
+		ofs << "}\n";
+
+		return ofs.good();
+	}
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	std::array<std::array<float, SampleCount>, PhaseCount> samples{};
+	std::array<clock::time_point, PhaseCount> phaseStart{};
+	int cursor{};
+	uint64_t completedFrames{};
+	bool started{};
+
+	int offset() const
+	{
+		return (cursor - size() + SampleCount) % SampleCount;
+	}
+};
@@ -0,0 +1,309 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <istream>
+
+// DEFLATE (RFC 1951) decoder that pulls compressed bytes from a stream and writes straight into a
+// caller supplied buffer. The whole output stays in that buffer, so it doubles as the history window
+// and nothing is allocated; this limits it to outputs that fit in memory, which every ROM does.
+class Inflater
+{
+public:
+	enum Result { Ok, Truncated, Corrupt, TooLarge };
+
+	Inflater(std::istream& in, uint64_t compressedSize) : in(in), remaining(compressedSize) {}
+
+	Result inflate(uint8_t* out, size_t capacity, size_t& size)
+	{
+		output = out;
+		outputCapacity = capacity;
+		produced = 0;
+
+		Result result { Ok };
+		bool last { false };
+
+		while (!last && result == Ok)
+		{
+			last = bits(1) == 1;
+
+			switch (bits(2))
+			{
+			case 0: result = storedBlock(); break;
+			case 1: result = fixedBlock(); break;
+			case 2: result = dynamicBlock(); break;
+			default: result = failed ? Truncated : Corrupt; break;
+			}
+		}
+
+		size = produced;
+		return result;
+	}
+
+private:
+	static constexpr int MaxBits = 15;
+	static constexpr int MaxLengthCodes = 286;
+	static constexpr int MaxDistanceCodes = 30;
+
+	struct Huffman
+	{
+		std::array<uint16_t, MaxBits + 1> counts;
+		std::array<uint16_t, 288> symbols;
+	};
+
+	std::istream& in;
+	uint64_t remaining;
+	std::array<char, 4096> buffer;
+	size_t bufferPos { 0 };
+	size_t bufferSize { 0 };
+	uint32_t bitBuffer { 0 };
+	int bitCount { 0 };
+	bool failed { false };
+
+	uint8_t* output { nullptr };
+	size_t outputCapacity { 0 };
+	size_t produced { 0 };
+
+	bool nextByte(uint8_t& byte)
+	{
+		if (bufferPos == bufferSize)
+		{
+			const size_t request = static_cast<size_t>(std::min<uint64_t>(buffer.size(), remaining));
+			in.read(buffer.data(), request);
+			bufferSize = static_cast<size_t>(in.gcount());
+			bufferPos = 0;
+			remaining -= bufferSize;
+
+			if (bufferSize == 0)
+			{
+				failed = true;
+				return false;
+			}
+		}
+
+		byte = static_cast<uint8_t>(buffer[bufferPos++]);
+		return true;
+	}
+
+	// Reads n bits LSB first; returns 0 bits once the input is exhausted and sets failed.
+	uint32_t bits(int n)
+	{
+		while (bitCount < n)
+		{
+			uint8_t byte { 0 };
+			if (!nextByte(byte)) return 0;
+
+			bitBuffer |= static_cast<uint32_t>(byte) << bitCount;
+			bitCount += 8;
+		}
+
+		const uint32_t value = bitBuffer & ((1u << n) - 1);
+		bitBuffer >>= n;
+		bitCount -= n;
+		return value;
+	}
+
+	// Canonical code construction, returns false for over-subscribed code lengths.
+	static bool build(Huffman& huffman, const uint8_t* lengths, int count)
+	{
+		huffman.counts.fill(0);
+		for (int symbol = 0; symbol < count; symbol++)
+			huffman.counts[lengths[symbol]]++;
+
+		int left { 1 };
+		for (int len = 1; len <= MaxBits; len++)
+		{
+			left = (left << 1) - huffman.counts[len];
+			if (left < 0) return false;
+		}
+
+		std::array<uint16_t, MaxBits + 1> offsets{};
+		for (int len = 1; len < MaxBits; len++)
+			offsets[len + 1] = offsets[len] + huffman.counts[len];
+
+		for (int symbol = 0; symbol < count; symbol++)
+		{
+			if (lengths[symbol] != 0)
+				huffman.symbols[offsets[lengths[symbol]]++] = static_cast<uint16_t>(symbol);
+		}
+
+		return true;
+	}
+
+	int decode(const Huffman& huffman)
+	{
+		int code { 0 }, first { 0 }, index { 0 };
+
+		for (int len = 1; len <= MaxBits; len++)
+		{
+			code |= static_cast<int>(bits(1));
+			const int count = huffman.counts[len];
+
+			if (code - count < first)
+				return huffman.symbols[index + (code - first)];
+
+			index += count;
+			first = (first + count) << 1;
+			code <<= 1;
+
+			if (failed) return -1;
+		}
+
+		return -1;
+	}
+
+	Result storedBlock()
+	{
+		bitBuffer = 0;
+		bitCount = 0;
+
+		const uint32_t length = bits(16);
+		const uint32_t inverted = bits(16);
+		if (failed) return Truncated;
+		if ((length ^ 0xFFFF) != inverted) return Corrupt;
+		if (produced + length > outputCapacity) return TooLarge;
+
+		for (uint32_t i = 0; i < length; i++)
+		{
+			if (!nextByte(output[produced++])) return Truncated;
+		}
+
+		return Ok;
+	}
+
+	Result fixedBlock()
+	{
+		static const auto tables = []()
+		{
+			std::array<Huffman, 2> fixed;
+			uint8_t lengths[288];
+			int symbol { 0 };
+
+			for (; symbol < 144; symbol++) lengths[symbol] = 8;
+			for (; symbol < 256; symbol++) lengths[symbol] = 9;
+			for (; symbol < 280; symbol++) lengths[symbol] = 7;
+			for (; symbol < 288; symbol++) lengths[symbol] = 8;
+			build(fixed[0], lengths, 288);
+
+			for (symbol = 0; symbol < MaxDistanceCodes; symbol++) lengths[symbol] = 5;
+			build(fixed[1], lengths, MaxDistanceCodes);
+
+			return fixed;
+		}();
+
+		return codes(tables[0], tables[1]);
+	}
+
+	Result dynamicBlock()
+	{
+		static constexpr uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+		const int lengthCount = static_cast<int>(bits(5)) + 257;
+		const int distanceCount = static_cast<int>(bits(5)) + 1;
+		const int codeCount = static_cast<int>(bits(4)) + 4;
+		if (failed) return Truncated;
+		if (lengthCount > MaxLengthCodes || distanceCount > MaxDistanceCodes) return Corrupt;
+
+		uint8_t lengths[MaxLengthCodes + MaxDistanceCodes] {};
+		for (int i = 0; i < codeCount; i++)
+			lengths[order[i]] = static_cast<uint8_t>(bits(3));
+
+		Huffman lengthCode, distanceCode;
+		if (!build(lengthCode, lengths, 19)) return Corrupt;
+
+		for (int index = 0; index < lengthCount + distanceCount;)
+		{
+			const int symbol = decode(lengthCode);
+			if (symbol < 0) return failed ? Truncated : Corrupt;
+
+			if (symbol < 16)
+			{
+				lengths[index++] = static_cast<uint8_t>(symbol);
+				continue;
+			}
+
+			uint8_t value { 0 };
+			int repeat { 0 };
+			if (symbol == 16)
+			{
+				if (index == 0) return Corrupt;
+				value = lengths[index - 1];
+				repeat = 3 + static_cast<int>(bits(2));
+			}
+			else if (symbol == 17)
+				repeat = 3 + static_cast<int>(bits(3));
+			else
+				repeat = 11 + static_cast<int>(bits(7));
+
+			if (index + repeat > lengthCount + distanceCount) return Corrupt;
+			while (repeat-- > 0)
+				lengths[index++] = value;
+		}
+
+		if (lengths[256] == 0) return Corrupt;
+		if (!build(lengthCode, lengths, lengthCount) || !build(distanceCode, lengths + lengthCount, distanceCount))
+			return Corrupt;
+
+		return codes(lengthCode, distanceCode);
+	}
+
+	Result codes(const Huffman& lengthCode, const Huffman& distanceCode)
+	{
+		static constexpr uint16_t lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+		static constexpr uint8_t lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+		static constexpr uint16_t distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+		static constexpr uint8_t distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+		while (true)
+		{
+			int symbol = decode(lengthCode);
+			if (symbol < 0) return failed ? Truncated : Corrupt;
+			if (symbol == 256) return Ok;
+
+			if (symbol < 256)
+			{
+				if (produced == outputCapacity) return TooLarge;
+				output[produced++] = static_cast<uint8_t>(symbol);
+				continue;
+			}
+
+			symbol -= 257;
+			if (symbol >= 29) return Corrupt;
+			const size_t length = lengthBase[symbol] + bits(lengthExtra[symbol]);
+
+			symbol = decode(distanceCode);
+			if (symbol < 0) return failed ? Truncated : Corrupt;
+			if (symbol >= 30) return Corrupt;
+			const size_t distance = distanceBase[symbol] + bits(distanceExtra[symbol]);
+
+			if (failed) return Truncated;
+			if (distance > produced) return Corrupt;
+			if (produced + length > outputCapacity) return TooLarge;
+
+			for (size_t i = 0; i < length; i++, produced++)
+				output[produced] = output[produced - distance];
+		}
+	}
+};
+
+inline uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+{
+	static const auto table = []()
+	{
+		std::array<uint32_t, 256> entries;
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t value = i;
+			for (int bit = 0; bit < 8; bit++)
+				value = (value & 1) ? 0xEDB88320 ^ (value >> 1) : value >> 1;
+			entries[i] = value;
+		}
+		return entries;
+	}();
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+	return ~crc;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// Host scancode to CHIP-8 key lookup. Scancodes index a dense table directly;
+// GLFW scancodes stay below 512 on Windows, X11 and Wayland.
+class KeyMap
+{
+public:
+	static constexpr int TableSize = 512;
+
+	KeyMap()
+	{
+		table.fill(-1);
+	}
+
+	// keyConfig.ini lines are "<chip key in hex>: <scancode>".
+	bool load(const char* path)
+	{
+		std::ifstream configFile(path);
+		if (!configFile) return false;
+
+		std::string line;
+		while (std::getline(configFile, line))
+		{
+			std::stringstream ss(line);
+			char chipKey;
+			int scancode;
+
+			ss >> chipKey;
+			ss.ignore(1);
+			if (!(ss >> scancode) || scancode < 0 || scancode >= TableSize) continue;
+
+			const int key = std::stoi(std::string { chipKey }, nullptr, 16);
+			table[scancode] = static_cast<int8_t>(key);
+		}
+
+		return true;
+	}
+
+	// Returns the CHIP-8 key bound to scancode, or -1.
+	inline int lookup(int scancode) const
+	{
+		return static_cast<unsigned>(scancode) < TableSize ? table[scancode] : -1;
+	}
+
+private:
+	std::array<int8_t, TableSize> table;
+};
+
+struct InputEvent
+{
+	double time;	// host time in seconds, same clock as glfwGetTime
+	uint8_t key;
+	bool pressed;
+};
+
+// Single producer, single consumer queue from the window callbacks to the emulation step.
+// Events are dropped when the consumer falls a full queue behind.
+class InputQueue
+{
+public:
+	static constexpr size_t Capacity = 256;
+
+	bool push(const InputEvent& event)
+	{
+		const size_t index = head.load(std::memory_order_relaxed);
+		if (index - tail.load(std::memory_order_acquire) == Capacity) return false;
+
+		events[index % Capacity] = event;
+		head.store(index + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool peek(InputEvent& event) const
+	{
+		const size_t index = tail.load(std::memory_order_relaxed);
+		if (index == head.load(std::memory_order_acquire)) return false;
+
+		event = events[index % Capacity];
+		return true;
+	}
+	void pop()
+	{
+		tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+private:
+	std::array<InputEvent, Capacity> events{};
+	std::atomic<size_t> head { 0 };
+	std::atomic<size_t> tail { 0 };
+};
@@ -0,0 +1,189 @@
+#pragma once
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Minimal JSON reader for the data files the emulator consumes. Values are parsed into a tree;
+// \u escapes outside ASCII are replaced with '?' since only keys and titles are ever read.
+struct JsonValue
+{
+	enum Type { Null, Bool, Number, String, Array, Object };
+
+	Type type { Null };
+	bool boolean { false };
+	double number { 0.0 };
+	std::string string;
+	std::vector<JsonValue> array;
+	std::vector<std::pair<std::string, JsonValue>> object;
+
+	const JsonValue* get(std::string_view key) const
+	{
+		for (const auto& [name, value] : object)
+		{
+			if (name == key)
+				return &value;
+		}
+
+		return nullptr;
+	}
+	bool getBool(std::string_view key, bool fallback) const
+	{
+		const JsonValue* value = get(key);
+		return value != nullptr && value->type == Bool ? value->boolean : fallback;
+	}
+	double getNumber(std::string_view key, double fallback) const
+	{
+		const JsonValue* value = get(key);
+		return value != nullptr && value->type == Number ? value->number : fallback;
+	}
+};
+
+class JsonParser
+{
+public:
+	static bool parse(std::string_view text, JsonValue& out)
+	{
+		JsonParser parser { text };
+		return parser.parseValue(out, 0) && (parser.skipWhitespace(), parser.pos == text.size());
+	}
+
+private:
+	static constexpr int MaxDepth = 64;
+
+	std::string_view text;
+	size_t pos { 0 };
+
+	explicit JsonParser(std::string_view text) : text(text) {}
+
+	void skipWhitespace()
+	{
+		while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r'))
+			pos++;
+	}
+	bool consume(char c)
+	{
+		skipWhitespace();
+		if (pos < text.size() && text[pos] == c)
+		{
+			pos++;
+			return true;
+		}
+
+		return false;
+	}
+	bool consumeLiteral(std::string_view literal)
+	{
+		if (text.substr(pos, literal.size()) != literal) return false;
+
+		pos += literal.size();
+		return true;
+	}
+
+	bool parseValue(JsonValue& out, int depth)
+	{
+		if (depth > MaxDepth) return false;
+
+		skipWhitespace();
+		if (pos >= text.size()) return false;
+
+		switch (text[pos])
+		{
+		case '{': return parseObject(out, depth);
+		case '[': return parseArray(out, depth);
+		case '"': out.type = JsonValue::String; return parseString(out.string);
+		case 't': out.type = JsonValue::Bool; out.boolean = true; return consumeLiteral("true");
+		case 'f': out.type = JsonValue::Bool; out.boolean = false; return consumeLiteral("false");
+		case 'n': out.type = JsonValue::Null; return consumeLiteral("null");
+		default: return parseNumber(out);
+		}
+	}
+
+	bool parseObject(JsonValue& out, int depth)
+	{
+		out.type = JsonValue::Object;
+		pos++;
+
+		if (consume('}')) return true;
+
+		do
+		{
+			std::string key;
+			skipWhitespace();
+			if (!parseString(key) || !consume(':')) return false;
+
+			out.object.emplace_back(std::move(key), JsonValue {});
+			if (!parseValue(out.object.back().second, depth + 1)) return false;
+		} while (consume(','));
+
+		return consume('}');
+	}
+
+	bool parseArray(JsonValue& out, int depth)
+	{
+		out.type = JsonValue::Array;
+		pos++;
+
+		if (consume(']')) return true;
+
+		do
+		{
+			out.array.emplace_back();
+			if (!parseValue(out.array.back(), depth + 1)) return false;
+		} while (consume(','));
+
+		return consume(']');
+	}
+
+	bool parseString(std::string& out)
+	{
+		if (pos >= text.size() || text[pos] != '"') return false;
+		pos++;
+
+		while (pos < text.size() && text[pos] != '"')
+		{
+			char c = text[pos++];
+			if (c != '\\')
+			{
+				out += c;
+				continue;
+			}
+
+			if (pos >= text.size()) return false;
+			switch (c = text[pos++])
+			{
+			case 'b': out += '\b'; break;
+			case 'f': out += '\f'; break;
+			case 'n': out += '\n'; break;
+			case 'r': out += '\r'; break;
+			case 't': out += '\t'; break;
+			case 'u':
+			{
+				if (pos + 4 > text.size()) return false;
+				const unsigned long code = std::strtoul(std::string(text.substr(pos, 4)).c_str(), nullptr, 16);
+				out += code < 0x80 ? static_cast<char>(code) : '?';
+				pos += 4;
+				break;
+			}
+			default: out += c; break;
+			}
+		}
+
+		return pos++ < text.size();
+	}
+
+	bool parseNumber(JsonValue& out)
+	{
+		const size_t start = pos;
+		while (pos < text.size() && ((text[pos] != '\0' && std::strchr("+-.eE", text[pos]) != nullptr) || (text[pos] >= '0' && text[pos] <= '9')))
+			pos++;
+
+		if (pos == start) return false;
+
+		out.type = JsonValue::Number;
+		out.number = std::strtod(std::string(text.substr(start, pos - start)).c_str(), nullptr);
+		return true;
+	}
+};
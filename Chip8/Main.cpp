@@ -8,19 +8,52 @@
 #include "GLFW/glfw3.h"
 #include "nfd/nfd.hpp"
 
+#include <algorithm>
 #include <array>
-#include <map>
+#include <cmath>
+#include <memory>
 #include <sstream>
 #include <iostream>   
 #include <filesystem>
-#include <thread>
+#include <fstream>
+#include <iterator>
+#include <utility>
+#include <vector>
 
 #include "Shader.h"
 #include "ChipCore.h"
+#include "Conformance.h"
+#include "Differential.h"
+#include "Debugger.h"
+#include "FramePacer.h"
+#include "FrameStats.h"
+#include "Input.h"
+#include "Archive.h"
+#include "RomDatabase.h"
+#include "RomLibrary.h"
+#include "Sha1.h"
+#include "VideoCapture.h"
 
 ChipCore chipCore {};
 bool pause { false };
 bool pixelBorders { false };
+int runAheadFrames { 0 };
+// Each frame's CPU burst is split into slices with events polled in between, so input lands
+// within a slice of when it happened instead of up to a frame later.
+int inputSlices { 4 };
+// Swaps wait for vertical blank. On a 60 Hz display the swap then paces frames, on other refresh
+// rates emulation speed stays on framePacer so 120/144 Hz monitors do not speed games up.
+bool vsync { false };
+int displayRefreshRate { 0 };
+// Frames emulated per presented frame while fast-forwarding, 0 runs as many as fit in each frame.
+int fastForwardSpeed { 4 };
+bool fastForwardToggle { false };
+bool fastForwardHeld { false };
+
+bool isFastForwarding()
+{
+    return fastForwardToggle || fastForwardHeld;
+}
 
 int menuBarHeight;
 GLFWwindow* window;
@@ -33,14 +66,19 @@ float widthUnit, heightUnit;
 int viewport_width, viewport_height;
 
 const std::wstring defaultPath { std::filesystem::current_path().wstring()};
-const nfdnfilteritem_t filterItem[2] = { {L"ROM File", L"ch8,bin,c8"} };
+const nfdnfilteritem_t filterItem[2] = { {L"ROM File", L"ch8,bin,c8,zip,gz"} };
+
+ChipState runAheadState {};
+ChipCore::ScreenBuffer displayBuffer {};
+ImVec4 foregroundColor { 1.0f, 1.0f, 1.0f, 1.0f };
+ImVec4 backgroundColor { 0.0f, 0.0f, 0.0f, 1.0f };
 
 void draw() {
     for (int x = 0; x < ChipCore::SCRWidth; x++)
     {
         for (int y = 0; y < ChipCore::SCRHeight; y++)
         {
-            if (chipCore.getPixel(x, y))
+            if (displayBuffer[ChipCore::SCRWidth * y + x])
             {
                 pixelShader.setFloat2("offset", x * (widthUnit + pixel_XGap), y * (heightUnit + pixel_YGap));
                 glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
@@ -97,14 +135,490 @@ void setBuffers()
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-std::wstring currentROMPAth {};
-void loadROM(const wchar_t* path)
+std::unique_ptr<CoverageMap> coverageMap;
+
+RomDatabase romDatabase { "data/chip-8-database" };
+bool useRomDatabase { true };
+std::string detectedTitle {};
+// The user's quirks and CPU frequency from before the database overrode them, put back for unknown ROMs.
+bool databaseApplied { false };
+Quirks::Profile userQuirks {};
+int userCPUfrequency {};
+
+// Picks the quirks and CPU frequency the database lists for the ROM, if it knows it.
+void applyRomDatabase(std::span<const uint8_t> rom)
 {
-    chipCore.loadROM(path);
+    detectedTitle.clear();
+    if (!databaseApplied)
+    {
+        userQuirks = Quirks::Current();
+        userCPUfrequency = chipCore.CPUfrequency;
+    }
+
+    const RomDatabase::RomInfo* info = romDatabase.find(Sha1::hash(rom.data(), rom.size()));
+    if (info == nullptr)
+    {
+        Quirks::Apply(userQuirks);
+        chipCore.CPUfrequency = userCPUfrequency;
+        databaseApplied = false;
+        return;
+    }
+
+    Quirks::Apply(info->quirks);
+    chipCore.CPUfrequency = info->tickrate > 0 ? info->tickrate * 60 : userCPUfrequency;
+    detectedTitle = info->title + " (" + info->platform + ")";
+    databaseApplied = true;
+}
+
+std::filesystem::path currentROMPAth {};
+// Shown in a popup until dismissed.
+std::string loadError {};
+
+// Reloading keeps the current quirks and speed, including any changed by hand since the ROM was opened.
+// The file is read once; the database is looked up by the hash of the same bytes the core loads.
+void loadROM(const std::filesystem::path& path, bool reload = false)
+{
+    uint8_t rom[ChipCore::MaxROMSize];
+    size_t size { 0 };
+
+    LoadResult result = Archive::readRom(path, rom, sizeof(rom), size);
+    if (result == LoadResult::Ok) result = chipCore.loadROM(std::span<const uint8_t>(rom, size));
+    if (result != LoadResult::Ok)
+    {
+        std::cout << "Failed to load ROM: " << describe(result) << std::endl;
+        const std::u8string name = path.filename().u8string();
+        loadError = std::string(name.begin(), name.end()) + ": " + describe(result);
+        return;
+    }
+
+    if (useRomDatabase && !reload) applyRomDatabase(std::span<const uint8_t>(rom, size));
+    displayBuffer.reset();
+    if (coverageMap != nullptr) coverageMap->clear();
     pause = false;
     currentROMPAth = path;
 }
 
+std::unique_ptr<TraceRing> traceRing;
+std::unique_ptr<TraceWriter> traceWriter;
+
+void toggleTrace()
+{
+    if (traceRing == nullptr)
+    {
+        constexpr size_t traceCapacityLog2 = 20;
+        traceRing = std::make_unique<TraceRing>(traceCapacityLog2);
+        chipCore.trace = traceRing.get();
+    }
+    else
+    {
+        traceWriter.reset();
+        chipCore.trace = nullptr;
+        traceRing.reset();
+    }
+}
+
+void toggleTraceWriter()
+{
+    if (traceWriter != nullptr)
+    {
+        traceWriter.reset();
+        return;
+    }
+
+    traceWriter = std::make_unique<TraceWriter>(*traceRing, "trace.c8t");
+    if (!traceWriter->isOpen())
+    {
+        std::cout << "Failed to open trace.c8t for writing" << std::endl;
+        traceWriter.reset();
+    }
+}
+
+std::unique_ptr<VideoCapture> videoCapture;
+int captureFormat { 0 };
+int captureScale { 4 };
+
+uint32_t packColor(const ImVec4& color)
+{
+    const auto channel = [](float value) { return static_cast<uint32_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f); };
+    return (channel(color.x) << 16) | (channel(color.y) << 8) | channel(color.z);
+}
+
+// Recordings are named after the ROM and written to the working directory.
+void toggleVideoCapture()
+{
+    if (videoCapture != nullptr)
+    {
+        videoCapture.reset();
+        return;
+    }
+
+    static constexpr const char* extensions[] = { ".y4m", ".gif", ".rgb" };
+    std::filesystem::path output = currentROMPAth.empty() ? std::filesystem::path("capture") : currentROMPAth.filename();
+    output.replace_extension(extensions[captureFormat]);
+
+    videoCapture = std::make_unique<VideoCapture>(output, captureScale, packColor(foregroundColor), packColor(backgroundColor));
+    if (!videoCapture->isOpen())
+    {
+        std::cout << "Failed to open " << output.string() << " for recording" << std::endl;
+        videoCapture.reset();
+    }
+}
+
+void toggleCoverage()
+{
+    if (coverageMap == nullptr)
+    {
+        coverageMap = std::make_unique<CoverageMap>();
+        chipCore.coverage = coverageMap.get();
+    }
+    else
+    {
+        chipCore.coverage = nullptr;
+        coverageMap.reset();
+    }
+}
+
+// Maps are stored next to the ROM and accumulate over sessions.
+// Maps are kept next to the ROM, or next to the archive for a ROM inside a zip.
+void saveCoverage()
+{
+    std::filesystem::path path = currentROMPAth;
+    std::filesystem::path archive;
+    std::string member;
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(path, error) && Archive::splitZipPath(path, archive, member))
+        path = archive.parent_path() / std::filesystem::path(member).filename();
+    path.replace_extension(".c8cov");
+
+    if (std::filesystem::exists(path, error) && !coverageMap->merge(path))
+        std::cout << "Failed to merge " << path.string() << ", overwriting it" << std::endl;
+    if (!coverageMap->save(path))
+        std::cout << "Failed to save coverage map to " << path.string() << std::endl;
+}
+
+RomLibrary romLibrary { "data/romDirectories.ini", "data/romIndex.txt" };
+bool showRomLibrary { false };
+
+void renderRomLibraryWindow()
+{
+    if (!ImGui::Begin("ROM Library", &showRomLibrary))
+    {
+        ImGui::End();
+        return;
+    }
+
+    static std::vector<RomLibrary::Entry> entries { romLibrary.getEntries() };
+    static bool wasScanning { false };
+    static ImGuiTextFilter filter;
+
+    const bool scanning = romLibrary.isScanning();
+    if (wasScanning && !scanning) entries = romLibrary.getEntries();
+    wasScanning = scanning;
+
+    if (ImGui::Button("Add Folder"))
+    {
+        NFD::UniquePathN outPath;
+        if (NFD::PickFolder(outPath, defaultPath.c_str()) == NFD_OKAY)
+        {
+            romLibrary.addDirectory(outPath.get());
+            romLibrary.scan();
+        }
+    }
+    ImGui::SameLine();
+    ImGui::BeginDisabled(scanning);
+    if (ImGui::Button("Rescan")) romLibrary.scan();
+    ImGui::EndDisabled();
+
+    if (scanning)
+    {
+        ImGui::SameLine();
+        ImGui::Text("Hashing %d / %d", romLibrary.hashedCount(), romLibrary.pendingCount());
+    }
+
+    if (ImGui::TreeNode("Folders"))
+    {
+        for (size_t i = 0; i < romLibrary.getDirectories().size(); i++)
+        {
+            ImGui::PushID(static_cast<int>(i));
+            const bool remove = ImGui::SmallButton("x");
+            ImGui::SameLine();
+            ImGui::TextUnformatted(romLibrary.getDirectories()[i].string().c_str());
+            ImGui::PopID();
+
+            if (remove) romLibrary.removeDirectory(i--);
+        }
+        ImGui::TreePop();
+    }
+
+    filter.Draw("Filter");
+
+    std::vector<const RomLibrary::Entry*> visible;
+    for (const RomLibrary::Entry& entry : entries)
+    {
+        if (filter.PassFilter(entry.name.c_str()))
+            visible.push_back(&entry);
+    }
+
+    if (ImGui::BeginTable("roms", 3, ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable))
+    {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Name");
+        ImGui::TableSetupColumn("Size", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableSetupColumn("SHA-1", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableHeadersRow();
+
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(visible.size()));
+
+        while (clipper.Step())
+        {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+            {
+                const RomLibrary::Entry& entry = *visible[row];
+
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::PushID(row);
+                if (ImGui::Selectable(entry.name.c_str(), false, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowDoubleClick) &&
+                    ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left))
+                    loadROM(entry.path);
+                ImGui::PopID();
+
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(entry.size));
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(entry.sha1.c_str(), entry.sha1.c_str() + std::min<size_t>(entry.sha1.size(), 12));
+            }
+        }
+
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+bool showDebugger { false };
+
+FramePacer framePacer {};
+
+// Whether the vsync'd swap sets the frame rate, leaving framePacer to space the input slices between swaps.
+bool pacedBySwap()
+{
+    return vsync && std::abs(displayRefreshRate - 60) <= 1;
+}
+
+// Sync to Audio scales the frame rate by audioRate, so emulation follows the sound card's clock.
+// It has no effect while the swap sets the frame rate, so it is held off then.
+bool audioSync { false };
+AudioRateControl audioRate {};
+
+void updateAudioSync()
+{
+    if (!audioSync || pacedBySwap() || pause || isFastForwarding() || chipCore.beeper == nullptr)
+        audioRate.reset();
+    else
+        audioRate.update(chipCore.beeper->getLead());
+}
+
+FrameStats frameStats {};
+bool showFrameStats { false };
+
+void renderFrameStatsWindow()
+{
+    if (!ImGui::Begin("Frame Timing", &showFrameStats))
+    {
+        ImGui::End();
+        return;
+    }
+
+    const auto getSample = [](void* data, int index) -> float
+    {
+        const auto phase = static_cast<FrameStats::Phase>(reinterpret_cast<intptr_t>(data));
+        return frameStats.sample(phase, index);
+    };
+
+    for (int phase = 0; phase < FrameStats::PhaseCount; phase++)
+    {
+        const FrameStats::Summary stats = frameStats.summary(static_cast<FrameStats::Phase>(phase));
+        char overlay[64];
+        std::snprintf(overlay, sizeof(overlay), "mean %.2f  p99 %.2f  max %.2f ms", stats.mean, stats.p99, stats.max);
+
+        ImGui::PlotLines(FrameStats::phaseNames[phase], getSample, reinterpret_cast<void*>(static_cast<intptr_t>(phase)),
+            frameStats.size(), 0, overlay, 0.0f, FLT_MAX, ImVec2(0, 40));
+    }
+
+    ImGui::Spacing();
+    if (ImGui::Button("Dump CSV")) frameStats.dumpCSV("frameStats.csv");
+    ImGui::SameLine();
+    if (ImGui::Button("Dump JSON")) frameStats.dumpJSON("frameStats.json");
+
+    ImGui::Text("Dropped ticks: %llu, spin margin %.2f ms", static_cast<unsigned long long>(framePacer.getDroppedTicks()),
+        framePacer.getSpinMarginMs());
+    if (audioSync)
+        ImGui::Text("Audio lead %.1f ms, rate %+.2f%%", audioRate.getLead() * 1000.0, (audioRate.getRateScale() - 1.0) * 100.0);
+
+    ImGui::End();
+}
+
+ChipCore::AudioConfig audioConfig {};
+
+void renderAudioDeviceSettings()
+{
+    static constexpr uint32_t sampleRates[] = { 22050, 44100, 48000 };
+    static constexpr uint32_t periodSizes[] = { 0, 64, 128, 256, 512, 1024 };
+
+    ma_backend backends[MA_BACKEND_COUNT];
+    size_t backendCount { 0 };
+    ma_get_enabled_backends(backends, MA_BACKEND_COUNT, &backendCount);
+
+    const char* backendName = audioConfig.backend < 0 ? "Automatic" : ma_get_backend_name(static_cast<ma_backend>(audioConfig.backend));
+    if (ImGui::BeginCombo("Backend", backendName))
+    {
+        if (ImGui::Selectable("Automatic", audioConfig.backend < 0)) audioConfig.backend = -1;
+        for (size_t i = 0; i < backendCount; i++)
+        {
+            if (ImGui::Selectable(ma_get_backend_name(backends[i]), audioConfig.backend == backends[i]))
+                audioConfig.backend = backends[i];
+        }
+        ImGui::EndCombo();
+    }
+
+    char label[32];
+    std::snprintf(label, sizeof(label), "%u Hz", audioConfig.sampleRate);
+    if (ImGui::BeginCombo("Sample Rate", label))
+    {
+        for (uint32_t rate : sampleRates)
+        {
+            std::snprintf(label, sizeof(label), "%u Hz", rate);
+            if (ImGui::Selectable(label, audioConfig.sampleRate == rate)) audioConfig.sampleRate = rate;
+        }
+        ImGui::EndCombo();
+    }
+
+    const auto periodLabel = [&label](uint32_t frames)
+    {
+        if (frames == 0) std::snprintf(label, sizeof(label), "Default");
+        else std::snprintf(label, sizeof(label), "%u frames", frames);
+        return label;
+    };
+    if (ImGui::BeginCombo("Period", periodLabel(audioConfig.periodFrames)))
+    {
+        for (uint32_t frames : periodSizes)
+        {
+            if (ImGui::Selectable(periodLabel(frames), audioConfig.periodFrames == frames)) audioConfig.periodFrames = frames;
+        }
+        ImGui::EndCombo();
+    }
+
+    ImGui::Checkbox("Mono", &audioConfig.mono);
+    ImGui::SameLine();
+    ImGui::Checkbox("16-bit", &audioConfig.s16);
+    ImGui::SameLine();
+    if (ImGui::Button("Apply")) chipCore.configureAudio(audioConfig);
+
+    const ChipCore::AudioStatus status = chipCore.getAudioStatus();
+    if (!status.running)
+        ImGui::TextDisabled("No audio device");
+    else
+        ImGui::TextDisabled("%s%s: %u Hz %s %s, %u x %u frames, %.1f ms", status.backend, status.nullDevice ? " (silent)" : "",
+            status.sampleRate, status.channels == 1 ? "mono" : "stereo", status.s16 ? "s16" : "f32",
+            status.periodFrames, status.periods, status.latencyMs);
+}
+
+#ifdef CHIP8_PROFILER
+bool showProfiler { false };
+
+void renderProfilerWindow()
+{
+    if (!ImGui::Begin("Profiler", &showProfiler))
+    {
+        ImGui::End();
+        return;
+    }
+
+    const Profiler& profiler = chipCore.profiler;
+    const uint64_t totalCycles = profiler.totalCycles();
+
+    ImGui::Text("Cycles: %llu", static_cast<unsigned long long>(totalCycles));
+    ImGui::SameLine();
+    if (ImGui::Button("Reset")) chipCore.profiler.reset();
+
+    if (profiler.drawCalls > 0)
+        ImGui::Text("DXYN: %llu calls, %.1f ns avg", static_cast<unsigned long long>(profiler.drawCalls),
+            static_cast<double>(profiler.drawNanoseconds) / profiler.drawCalls);
+
+    ImGui::SeparatorText("Opcode classes");
+    float opcodeHistogram[16];
+    for (int i = 0; i < 16; i++)
+        opcodeHistogram[i] = static_cast<float>(profiler.opcodeCounts[i]);
+
+    ImGui::PlotHistogram("0-F", opcodeHistogram, 16, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+
+    ImGui::SeparatorText("Heatmap");
+    const uint64_t maxCount = *std::max_element(profiler.pcCounts.begin(), profiler.pcCounts.end());
+    const float cellSize = ImGui::GetFontSize() * 0.4f;
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+
+    for (int addr = 0; addr < 4096; addr++)
+    {
+        const uint64_t count = profiler.pcCounts[addr];
+        if (count == 0) continue;
+
+        const float heat = static_cast<float>(std::log1p(static_cast<double>(count)) / std::log1p(static_cast<double>(maxCount)));
+        const ImVec2 cellMin { origin.x + (addr % 64) * cellSize, origin.y + (addr / 64) * cellSize };
+        drawList->AddRectFilled(cellMin, ImVec2(cellMin.x + cellSize, cellMin.y + cellSize), ImColor(heat, 0.2f, 1.0f - heat));
+    }
+
+    ImGui::InvisibleButton("heatmap", ImVec2(cellSize * 64, cellSize * 64));
+    if (ImGui::IsItemHovered())
+    {
+        const ImVec2 mouse = ImGui::GetMousePos();
+        const int addr = static_cast<int>((mouse.y - origin.y) / cellSize) * 64 + static_cast<int>((mouse.x - origin.x) / cellSize);
+        if (addr >= 0 && addr < 4096)
+            ImGui::SetTooltip("0x%03X: %llu", addr, static_cast<unsigned long long>(profiler.pcCounts[addr]));
+    }
+
+    ImGui::SeparatorText("Hot spots");
+    static std::vector<uint16_t> hotSpots;
+    hotSpots.clear();
+    for (uint16_t addr = 0; addr < 4096; addr++)
+    {
+        if (profiler.pcCounts[addr] > 0)
+            hotSpots.push_back(addr);
+    }
+
+    const size_t shown = std::min<size_t>(hotSpots.size(), 32);
+    std::partial_sort(hotSpots.begin(), hotSpots.begin() + shown, hotSpots.end(),
+        [&profiler](uint16_t a, uint16_t b) { return profiler.pcCounts[a] > profiler.pcCounts[b]; });
+
+    if (ImGui::BeginTable("hotSpots", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders))
+    {
+        ImGui::TableSetupColumn("PC");
+        ImGui::TableSetupColumn("Count");
+        ImGui::TableSetupColumn("%");
+        ImGui::TableHeadersRow();
+
+        for (size_t i = 0; i < shown; i++)
+        {
+            const uint64_t count = profiler.pcCounts[hotSpots[i]];
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("0x%03X", hotSpots[i]);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", static_cast<unsigned long long>(count));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", 100.0 * count / totalCycles);
+        }
+
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+#endif
+
 void renderImGUI()
 {
     ImGui_ImplOpenGL3_NewFrame();
@@ -124,7 +638,19 @@ void renderImGUI()
                     loadROM(outPath.get());
             }
             else if (ImGui::MenuItem("Reload ROM", "(Esc)"))
-                loadROM(currentROMPAth.c_str());
+                loadROM(currentROMPAth, true);
+            ImGui::MenuItem("ROM Library", nullptr, &showRomLibrary);
+
+            ImGui::SeparatorText("Video Capture");
+            ImGui::BeginDisabled(videoCapture != nullptr);
+            ImGui::Combo("Format", &captureFormat, "Y4M\0GIF\0Raw RGB\0");
+            ImGui::SliderInt("Scale", &captureScale, 1, 16);
+            ImGui::EndDisabled();
+            if (ImGui::MenuItem("Record Video", nullptr, videoCapture != nullptr))
+                toggleVideoCapture();
+            if (videoCapture != nullptr)
+                ImGui::TextDisabled("%llu frames, %llu dropped", static_cast<unsigned long long>(videoCapture->framesWritten()),
+                    static_cast<unsigned long long>(videoCapture->droppedFrames()));
 
             ImGui::EndMenu();
         }
@@ -136,6 +662,22 @@ void renderImGUI()
 
             ImGui::SeparatorText("CPU");
             ImGui::SliderInt("CPU Frequency", &chipCore.CPUfrequency, 60, 1500);
+            ImGui::BeginDisabled(!romDatabase.isAvailable());
+            ImGui::Checkbox("Use ROM Database", &useRomDatabase);
+            ImGui::EndDisabled();
+            if (!detectedTitle.empty()) ImGui::TextDisabled("%s", detectedTitle.c_str());
+            ImGui::SliderInt("Run-Ahead Frames", &runAheadFrames, 0, 4);
+            ImGui::SliderInt("Input Slices", &inputSlices, 1, 8);
+            ImGui::SliderInt("Fast-Forward Speed", &fastForwardSpeed, 0, 16, fastForwardSpeed == 0 ? "Unlimited" : "%dx");
+            ImGui::Checkbox("Fast-Forward (hold `)", &fastForwardToggle);
+            ImGui::BeginDisabled(pacedBySwap());
+            ImGui::Checkbox("Sync to Audio", &audioSync);
+            ImGui::EndDisabled();
+            if (pacedBySwap()) ImGui::TextDisabled("Off while vsync sets the frame rate");
+
+            int engine = static_cast<int>(chipCore.engine);
+            if (ImGui::Combo("Engine", &engine, "Switch\0Table\0"))
+                chipCore.engine = static_cast<ChipCore::Engine>(engine);
 
             ImGui::SeparatorText("Sound");
             ImGui::Checkbox("Enable Sound", &chipCore.enableSound);
@@ -147,14 +689,18 @@ void renderImGUI()
                 if (ImGui::SliderInt("Volume", &volume, 0, 100))
                     chipCore.setVolume(volume / 100.0);
             }
+            if (ImGui::TreeNode("Audio Device"))
+            {
+                renderAudioDeviceSettings();
+                ImGui::TreePop();
+            }
 
             ImGui::SeparatorText("UI");
 
             if (ImGui::Checkbox("Pixel Gaps", &pixelBorders))
                 updateVertices();
-
-            static ImVec4 foregroundColor = ImVec4(1.0f, 1.0f, 1.0f, 1.0f);
-            static ImVec4 backgroundColor = ImVec4(0.0f, 0.0f, 0.0f, 1.0f);
+            if (ImGui::Checkbox("VSync", &vsync))
+                glfwSwapInterval(vsync ? 1 : 0);
 
             ImGui::Separator();
             ImGui::Spacing();
@@ -203,9 +749,22 @@ void renderImGUI()
 
                 chipCore.CPUfrequency = 500;
                 chipCore.enableSound = true;
+                runAheadFrames = 0;
+                inputSlices = 4;
+                fastForwardSpeed = 4;
+                fastForwardToggle = false;
+                audioSync = false;
+                vsync = false;
+                glfwSwapInterval(0);
+                chipCore.engine = ChipCore::Engine::Switch;
 
                 volume = 50;
                 chipCore.setVolume(0.5);
+                if (audioConfig != ChipCore::AudioConfig {})
+                {
+                    audioConfig = {};
+                    chipCore.configureAudio(audioConfig);
+                }
             }
 
             ImGui::EndMenu();
@@ -218,70 +777,265 @@ void renderImGUI()
             ImGui::Checkbox("Clipping", &Quirks::Clipping);
             ImGui::Checkbox("Memory Increment", &Quirks::MemoryIncrement);
 
+            ImGui::SeparatorText("Presets");
+            for (const Quirks::Profile& profile : Quirks::Profiles)
+            {
+                if (ImGui::Button(profile.name)) Quirks::Apply(profile);
+                ImGui::SameLine();
+            }
+            ImGui::NewLine();
+
             ImGui::Spacing();
             ImGui::Separator();
             if (ImGui::Button("Reset to Default")) Quirks::Reset();
             ImGui::EndMenu();
         }
+        if (ImGui::BeginMenu("Debug"))
+        {
+            ImGui::MenuItem("Debugger", nullptr, &showDebugger);
+            ImGui::MenuItem("Frame Timing", nullptr, &showFrameStats);
+#ifdef CHIP8_PROFILER
+            ImGui::MenuItem("Profiler", nullptr, &showProfiler);
+#endif
+            ImGui::SeparatorText("Trace");
+            if (ImGui::MenuItem("Flight Recorder", nullptr, traceRing != nullptr))
+                toggleTrace();
+            if (ImGui::MenuItem("Stream to trace.c8t", nullptr, traceWriter != nullptr, traceRing != nullptr))
+                toggleTraceWriter();
+            if (ImGui::MenuItem("Dump Recent to recent.c8t", nullptr, false, traceRing != nullptr))
+                traceRing->dumpRecent("recent.c8t");
+
+            ImGui::SeparatorText("Coverage");
+            if (ImGui::MenuItem("Record Coverage", nullptr, coverageMap != nullptr))
+                toggleCoverage();
+            if (ImGui::MenuItem("Save Coverage Map", nullptr, false, coverageMap != nullptr))
+                saveCoverage();
+            if (coverageMap != nullptr)
+                ImGui::TextDisabled("%d code, %d data bytes", coverageMap->count(Coverage_Executed),
+                    coverageMap->count(Coverage_Sprite | Coverage_Load | Coverage_Written));
+
+            ImGui::EndMenu();
+        }
         if (pause)
         {
             ImGui::Separator();
             ImGui::Text("Paused");
         }
+        else if (isFastForwarding())
+        {
+            ImGui::Separator();
+            fastForwardSpeed == 0 ? ImGui::Text("Fast-Forward") : ImGui::Text("Fast-Forward %dx", fastForwardSpeed);
+        }
+        if (videoCapture != nullptr)
+        {
+            ImGui::Separator();
+            ImGui::Text("REC");
+        }
         ImGui::EndMainMenuBar();
     }
 
+    if (showRomLibrary) renderRomLibraryWindow();
+    if (showDebugger) renderDebuggerWindow(chipCore, pause, &showDebugger);
+    if (showFrameStats) renderFrameStatsWindow();
+#ifdef CHIP8_PROFILER
+    if (showProfiler) renderProfilerWindow();
+#endif
+
+    if (!loadError.empty()) ImGui::OpenPopup("Failed to load ROM");
+    if (ImGui::BeginPopupModal("Failed to load ROM", nullptr, ImGuiWindowFlags_AlwaysAutoResize))
+    {
+        ImGui::Text("%s", loadError.c_str());
+        if (ImGui::Button("OK"))
+        {
+            loadError.clear();
+            ImGui::CloseCurrentPopup();
+        }
+        ImGui::EndPopup();
+    }
+
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
 
-void render()
+double cpuRemainderCycles{};
+
+KeyMap keyMap {};
+InputQueue inputQueue {};
+// Time of the glfwPollEvents call that is dispatching key events. GLFW does not say when a key was pressed
+// within the wait before the poll, so events are stamped with this and each slice emulates the host time
+// from its poll onwards: polled events land on the first cycle of the next slice and input is quantised
+// to slices (Settings -> Input Slices).
+double pollTime{};
+
+// Runs count cycles standing for host time [start, end), applying each queued key event at the cycle
+// matching its timestamp. Later events stay queued for the next call, as do all events after a breakpoint.
+void runCyclesWithInput(int count, double start, double end)
 {
-    glClear(GL_COLOR_BUFFER_BIT);
-    draw();
-    renderImGUI();
-    glfwSwapBuffers(window);
+    int executed { 0 };
+    InputEvent event;
+    const double span = end - start;
+
+    while (inputQueue.peek(event) && event.time < end)
+    {
+        const double position = span > 0.0 ? std::clamp((event.time - start) / span, 0.0, 1.0) : 0.0;
+        const int at = std::clamp(static_cast<int>(position * count), executed, count);
+        executed += chipCore.runCycles(at - executed);
+        if (chipCore.hitBreakpoint()) return;
+
+        chipCore.setKey(event.key, event.pressed);
+        inputQueue.pop();
+    }
+
+    chipCore.runCycles(count - executed);
 }
 
-std::map<int, uint8_t> keyConfig{};
-void loadKeyConfig()
+// Applies queued key events immediately, for when the emulation is not running.
+void flushInput()
 {
-    std::ifstream configFile("data/keyConfig.ini");
-    std::string line;
+    InputEvent event;
+
+    while (inputQueue.peek(event))
+    {
+        chipCore.setKey(event.key, event.pressed);
+        inputQueue.pop();
+    }
+}
+
+int frameSlices { 1 };
+int frameCycles {};
+
+int nextFrameCycles()
+{
+    double cycles = (chipCore.CPUfrequency / 60.0) + cpuRemainderCycles;
+    int wholeCycles { static_cast<int>(cycles) };
+    cpuRemainderCycles = cycles - wholeCycles;
+
+    return wholeCycles;
+}
+
+// Emulates the frames that are skipped rather than presented while fast-forwarding.
+// Fast-forward runs one slice per frame, so unlimited speed gets most of a 60 Hz tick.
+void runSkippedFrames()
+{
+    constexpr double unlimitedBudget = 0.75 / 60;
+    const double deadline = glfwGetTime() + unlimitedBudget;
+
+    for (int frame = 1; fastForwardSpeed == 0 ? glfwGetTime() < deadline : frame < fastForwardSpeed; frame++)
+    {
+        chipCore.updateTimers();
+        chipCore.runCycles(nextFrameCycles());
+        if (videoCapture != nullptr) videoCapture->push(chipCore.getScreenBuffer());
 
-    while (std::getline(configFile, line)) {
-        std::stringstream ss(line);
-        char chipKey;
-        int bindValue;
+        if (chipCore.hitBreakpoint())
+        {
+            pause = true;
+            return;
+        }
+    }
+}
 
-        ss >> chipKey;
-        ss.ignore(1);
-        ss >> bindValue;
+// Runs one slice of the current frame, standing for the host time from sliceStart to the next slice.
+// The first slice also starts the frame.
+void emulateSlice(int slice, double sliceStart)
+{
+    if (slice == 0)
+    {
+        chipCore.muted = isFastForwarding();
+        if (isFastForwarding())
+        {
+            runSkippedFrames();
+            if (pause) return;
+        }
 
-        keyConfig[bindValue] = std::stoi(std::string{ chipKey }, 0, 16);
+        chipCore.updateTimers();
+        frameCycles = nextFrameCycles();
     }
+
+    const int begin = frameCycles * slice / frameSlices;
+    const int end = frameCycles * (slice + 1) / frameSlices;
+    runCyclesWithInput(end - begin, sliceStart, sliceStart + 1.0 / (60.0 * frameSlices));
+
+    if (chipCore.hitBreakpoint())
+        pause = true;
+}
+
+void finishFrame()
+{
+    if (videoCapture != nullptr && !pause) videoCapture->push(chipCore.getScreenBuffer());
+
+    if (pause || runAheadFrames == 0 || chipCore.hasBreakpoints() || chipCore.hasWatchpoints())
+    {
+        displayBuffer = chipCore.getScreenBuffer();
+        return;
+    }
+
+    chipCore.saveState(runAheadState);
+    TraceRing* trace = std::exchange(chipCore.trace, nullptr);
+    Beeper* beeper = std::exchange(chipCore.beeper, nullptr);
+    CoverageMap* coverage = std::exchange(chipCore.coverage, nullptr);
+#ifdef CHIP8_PROFILER
+    const bool profiling = std::exchange(chipCore.profiler.enabled, false);
+#endif
+
+    for (int i = 0; i < runAheadFrames; i++)
+    {
+        chipCore.updateTimers();
+        chipCore.runCycles(chipCore.CPUfrequency / 60);
+    }
+
+    displayBuffer = chipCore.getScreenBuffer();
+    chipCore.loadState(runAheadState);
+    chipCore.trace = trace;
+    chipCore.beeper = beeper;
+    chipCore.coverage = coverage;
+#ifdef CHIP8_PROFILER
+    chipCore.profiler.enabled = profiling;
+#endif
+}
+
+void render()
+{
+    frameStats.begin(FrameStats::Draw);
+    glClear(GL_COLOR_BUFFER_BIT);
+    draw();
+    frameStats.end(FrameStats::Draw);
+
+    frameStats.begin(FrameStats::ImGUI);
+    renderImGUI();
+    frameStats.end(FrameStats::ImGUI);
+
+    frameStats.begin(FrameStats::Swap);
+    glfwSwapBuffers(window);
+    frameStats.end(FrameStats::Swap);
 }
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
-    if (action == 1)
+    if (action == GLFW_PRESS)
     {
         if (key == GLFW_KEY_ESCAPE)
         {
-            loadROM(currentROMPAth.c_str());
+            loadROM(currentROMPAth, true);
             return;
         }
         if (key == GLFW_KEY_TAB)
         {
             pause = !pause;
+            if (!pause) chipCore.resume();
             return;
         }
     }
 
-    auto keyInd = keyConfig.find(scancode);
+    if (key == GLFW_KEY_GRAVE_ACCENT)
+    {
+        fastForwardHeld = action != GLFW_RELEASE;
+        return;
+    }
+
+    const int chipKey = keyMap.lookup(scancode);
 
-    if (keyInd != keyConfig.end())
-        chipCore.setKey(keyInd->second, action);
+    if (chipKey >= 0 && action != GLFW_REPEAT)
+        inputQueue.push({ pollTime, static_cast<uint8_t>(chipKey), action == GLFW_PRESS });
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
@@ -289,7 +1043,12 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     viewport_width = width; viewport_height = height - menuBarHeight;
     glViewport(0, 0, viewport_width, viewport_height);
     updateVertices();
-    render();
+
+    // Redraws while the window is being resized are not part of a frame, so they skip the frame stats.
+    glClear(GL_COLOR_BUFFER_BIT);
+    draw();
+    renderImGUI();
+    glfwSwapBuffers(window);
 }
 
 void setWindowSize()
@@ -327,6 +1086,8 @@ bool setGLFW()
     }
 
     glfwMakeContextCurrent(window);
+    glfwSwapInterval(vsync ? 1 : 0);
+    displayRefreshRate = glfwGetVideoMode(glfwGetPrimaryMonitor())->refreshRate;
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetKeyCallback(window, key_callback);
 
@@ -354,7 +1115,14 @@ void setImGUI()
     ImGui_ImplOpenGL3_Init("#version 330");
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc >= 3 && std::string_view { argv[1] } == "--conformance")
+        return runConformance(argv[2], argc >= 4 && std::string_view { argv[3] } == "--record");
+    if (argc >= 4 && std::string_view { argv[1] } == "--record")
+        return runRecording(argv[2], argv[3], argc >= 5 ? std::atoi(argv[4]) : 3600, argc >= 6 ? std::atoi(argv[5]) : 4);
+    if (argc >= 3 && std::string_view { argv[1] } == "--diff")
+        return runDifferential(argv[2], argc >= 4 ? std::atoi(argv[3]) : 3600, argc >= 5 ? std::atoi(argv[4]) : 64);
+
     if (!setGLFW()) return -1;
     setImGUI();
     setWindowSize();
@@ -368,41 +1136,47 @@ int main() {
     glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 
     NFD::Guard nfdGuard;
-    loadKeyConfig();
+    keyMap.load("data/keyConfig.ini");
     loadROM(L"ROMs/chipLogo.ch8");
+    romLibrary.scan();
 
-    double lastTime = glfwGetTime();
-    double timer{};
-    double cpuRemainderCycles{};
+    int slice{};
 
     while (!glfwWindowShouldClose(window)) 
     {
-        double currentTime = glfwGetTime();
-        double deltaTime = currentTime - lastTime;
-        timer += deltaTime;
-
-        if (timer >= 1.0 / 60)
+        if (slice == 0)
         {
-            timer = 0;
-
-            if (!pause)
-            {
-                chipCore.updateTimers();
+            // Skipped frames all run in the first slice, which would overrun a slice-length tick,
+            // so fast-forward runs one slice per frame and spends most of the frame on them.
+            frameSlices = isFastForwarding() ? 1 : inputSlices;
+            updateAudioSync();
+            framePacer.setRate(60.0 * frameSlices * audioRate.getRateScale());
+            frameStats.nextFrame();
+        }
 
-                double cycles = (chipCore.CPUfrequency / 60.0) + cpuRemainderCycles;
-                int wholeCycles { static_cast<int>(cycles) };
-                cpuRemainderCycles = cycles - wholeCycles;
+        if (slice != 0 || !pacedBySwap())
+            framePacer.wait();
+        pollTime = glfwGetTime();
+        glfwPollEvents();
 
-                for (int i = 0; i < wholeCycles; i++)
-                    chipCore.emulateCycle();
-            }
+        frameStats.begin(FrameStats::CPU);
+        if (!pause)
+            emulateSlice(slice, pollTime);
+        else
+            flushInput();
 
-            glfwPollEvents();
-            render();         
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (++slice == frameSlices)
+        {
+            slice = 0;
+            finishFrame();
         }
+        frameStats.end(FrameStats::CPU);
 
-        lastTime = currentTime;
+        if (slice == 0)
+        {
+            render();
+            if (pacedBySwap()) framePacer.restart();
+        }
     }
 
     ImGui_ImplOpenGL3_Shutdown();
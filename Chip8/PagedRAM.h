@@ -0,0 +1,122 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include "StateHash.h"
+
+// 4 KB of CHIP-8 memory split into reference counted pages.
+// Copies share every page and a page is duplicated only on its first write,
+// so forking a core costs 16 pointer copies instead of a full RAM copy.
+class PagedRAM
+{
+public:
+	static constexpr int Size = 4096;
+	static constexpr int PageSize = 256;
+	static constexpr int PageCount = Size / PageSize;
+
+	PagedRAM()
+	{
+		for (auto& page : pages)
+			page = std::make_shared<Page>();
+	}
+
+	inline uint8_t read(uint16_t addr) const
+	{
+		return pages[(addr & 0xFFF) / PageSize]->data[addr % PageSize];
+	}
+	inline void write(uint16_t addr, uint8_t val)
+	{
+		uint8_t& cell = writablePage(addr)->data[addr % PageSize];
+		versions[(addr & 0xFFF) / PageSize]++;
+		contentHash ^= StateHash::ramKey(addr & 0xFFF, cell) ^ StateHash::ramKey(addr & 0xFFF, val);
+		cell = val;
+	}
+
+	inline uint64_t hash() const
+	{
+		return contentHash;
+	}
+	// Bumped on every write to the page, lets caches of derived data skip unchanged pages.
+	inline uint32_t version(int page) const
+	{
+		return versions[page];
+	}
+
+	void clear()
+	{
+		for (auto& page : pages)
+		{
+			if (page.use_count() > 1)
+				page = std::make_shared<Page>();
+			else
+				page->data.fill(0);
+		}
+
+		for (uint32_t& version : versions)
+			version++;
+
+		contentHash = 0;
+	}
+
+	// Pages whose bytes already match are left alone, so restoring a snapshot only touches
+	// (and bumps the versions of) the pages that changed since it was taken.
+	void copyFrom(uint16_t addr, const uint8_t* src, size_t size)
+	{
+		while (size > 0 && addr < Size)
+		{
+			const size_t offset = addr % PageSize;
+			const size_t chunk = std::min(size, PageSize - offset);
+
+			if (std::memcmp(&pages[addr / PageSize]->data[offset], src, chunk) != 0)
+			{
+				uint8_t* dst = &writablePage(addr)->data[offset];
+				versions[addr / PageSize]++;
+
+				for (size_t i = 0; i < chunk; i++)
+					contentHash ^= StateHash::ramKey(addr + i, dst[i]) ^ StateHash::ramKey(addr + i, src[i]);
+
+				std::memcpy(dst, src, chunk);
+			}
+
+			addr += static_cast<uint16_t>(chunk);
+			src += chunk;
+			size -= chunk;
+		}
+	}
+	void copyTo(uint8_t* dst) const
+	{
+		for (int i = 0; i < PageCount; i++)
+			std::memcpy(dst + i * PageSize, pages[i]->data.data(), PageSize);
+	}
+
+	int sharedPageCount() const
+	{
+		int count { 0 };
+		for (const auto& page : pages)
+			count += page.use_count() > 1;
+
+		return count;
+	}
+
+private:
+	struct Page
+	{
+		std::array<uint8_t, PageSize> data{};
+	};
+
+	std::array<std::shared_ptr<Page>, PageCount> pages;
+	std::array<uint32_t, PageCount> versions{};
+	uint64_t contentHash { 0 };
+
+	inline Page* writablePage(uint16_t addr)
+	{
+		std::shared_ptr<Page>& page = pages[(addr & 0xFFF) / PageSize];
+
+		if (page.use_count() > 1)
+			page = std::make_shared<Page>(*page);
+
+		return page.get();
+	}
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// Execution counters filled by ChipCore::emulateCycle when built with CHIP8_PROFILER.
+struct Profiler
+{
+	std::array<uint64_t, 4096> pcCounts{};
+	std::array<uint64_t, 16> opcodeCounts{};
+
+	uint64_t drawCalls{};
+	uint64_t drawNanoseconds{};
+	// Cleared while running frames that will be rolled back, such as run-ahead.
+	bool enabled { true };
+
+	uint64_t totalCycles() const
+	{
+		uint64_t total{};
+		for (uint64_t count : opcodeCounts)
+			total += count;
+
+		return total;
+	}
+
+	void reset()
+	{
+		pcCounts.fill(0);
+		opcodeCounts.fill(0);
+		drawCalls = 0;
+		drawNanoseconds = 0;
+	}
+};
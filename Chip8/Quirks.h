@@ -1,18 +1,59 @@
 #pragma once
+#include <string_view>
+
 namespace Quirks
 {
-	static bool VFReset { true };
-	static bool MemoryIncrement { false };
-	static bool Clipping { true };
-	static bool Shifting { true };
-	static bool Jumping { false };
+	inline bool VFReset { true };
+	inline bool MemoryIncrement { false };
+	inline bool Clipping { true };
+	inline bool Shifting { true };
+	inline bool Jumping { false };
+
+	struct Profile
+	{
+		const char* name;
+		bool VFReset;
+		bool MemoryIncrement;
+		bool Clipping;
+		bool Shifting;
+		bool Jumping;
+	};
+
+	inline constexpr Profile Profiles[] =
+	{
+		{ "default", true, false, true, true, false },
+		{ "chip8", true, true, true, false, false },
+		{ "schip", false, false, true, true, true },
+		{ "xochip", false, true, false, false, false },
+	};
+
+	inline void Apply(const Profile& profile)
+	{
+		VFReset = profile.VFReset;
+		MemoryIncrement = profile.MemoryIncrement;
+		Clipping = profile.Clipping;
+		Shifting = profile.Shifting;
+		Jumping = profile.Jumping;
+	}
+
+	inline Profile Current()
+	{
+		return { "custom", VFReset, MemoryIncrement, Clipping, Shifting, Jumping };
+	}
+
+	inline const Profile* FindProfile(std::string_view name)
+	{
+		for (const Profile& profile : Profiles)
+		{
+			if (name == profile.name)
+				return &profile;
+		}
+
+		return nullptr;
+	}
 
 	inline void Reset()
 	{
-		VFReset = true;
-		MemoryIncrement = false;
-		Clipping = true;
-		Shifting = true;
-		Jumping = false;
+		Apply(Profiles[0]);
 	}
-}
\ No newline at end of file
+}
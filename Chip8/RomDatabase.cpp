@@ -0,0 +1,97 @@
+#include "RomDatabase.h"
+#include "Json.h"
+
+#include <fstream>
+#include <iterator>
+
+static bool readJson(const std::filesystem::path& path, JsonValue& out)
+{
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) return false;
+
+    const std::string text { std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>() };
+    return JsonParser::parse(text, out);
+}
+
+// The database's quirk names mapped onto ours. vblank has no equivalent and is ignored.
+static Quirks::Profile toProfile(const JsonValue& quirks, const Quirks::Profile& base)
+{
+    Quirks::Profile profile = base;
+    profile.name = "database";
+    profile.VFReset = quirks.getBool("logic", base.VFReset);
+    profile.MemoryIncrement = !quirks.getBool("memoryLeaveIUnchanged", !base.MemoryIncrement) && !quirks.getBool("memoryIncrementByX", false);
+    profile.Clipping = !quirks.getBool("wrap", !base.Clipping);
+    profile.Shifting = quirks.getBool("shift", base.Shifting);
+    profile.Jumping = quirks.getBool("jump", base.Jumping);
+
+    return profile;
+}
+
+const RomDatabase::RomInfo* RomDatabase::find(const std::string& sha1)
+{
+    if (!loaded) load();
+
+    const auto it = roms.find(sha1);
+    return it != roms.end() ? &it->second : nullptr;
+}
+
+bool RomDatabase::isAvailable()
+{
+    if (!loaded) load();
+    return !roms.empty();
+}
+
+void RomDatabase::load()
+{
+    loaded = true;
+
+    JsonValue platforms, programs;
+    if (!readJson(directory / "platforms.json", platforms) || !readJson(directory / "programs.json", programs))
+        return;
+
+    std::unordered_map<std::string, Quirks::Profile> platformQuirks;
+    std::unordered_map<std::string, int> platformTickrates;
+    for (const JsonValue& platform : platforms.array)
+    {
+        const JsonValue* id = platform.get("id");
+        const JsonValue* quirks = platform.get("quirks");
+        if (id == nullptr) continue;
+
+        if (quirks != nullptr)
+            platformQuirks.emplace(id->string, toProfile(*quirks, Quirks::Profiles[0]));
+        platformTickrates.emplace(id->string, static_cast<int>(platform.getNumber("defaultTickrate", 0)));
+    }
+
+    for (const JsonValue& program : programs.array)
+    {
+        const JsonValue* title = program.get("title");
+        const JsonValue* romList = program.get("roms");
+        if (romList == nullptr) continue;
+
+        for (const auto& [hash, rom] : romList->object)
+        {
+            RomInfo info { title != nullptr ? title->string : std::string {}, {}, Quirks::Profiles[0], static_cast<int>(rom.getNumber("tickrate", 0)) };
+
+            // The first listed platform is the one the ROM was written for.
+            const JsonValue* romPlatforms = rom.get("platforms");
+            if (romPlatforms != nullptr && !romPlatforms->array.empty())
+            {
+                info.platform = romPlatforms->array[0].string;
+
+                const auto platform = platformQuirks.find(info.platform);
+                if (platform != platformQuirks.end()) info.quirks = platform->second;
+
+                // ROMs without their own tickrate run at their platform's.
+                const auto tickrate = platformTickrates.find(info.platform);
+                if (info.tickrate == 0 && tickrate != platformTickrates.end()) info.tickrate = tickrate->second;
+            }
+
+            // Per-ROM overrides of the platform's quirks.
+            const JsonValue* quirky = rom.get("quirkyPlatforms");
+            const JsonValue* overrides = quirky != nullptr ? quirky->get(info.platform) : nullptr;
+            if (overrides != nullptr) info.quirks = toProfile(*overrides, info.quirks);
+
+            roms.emplace(hash, std::move(info));
+        }
+    }
+}
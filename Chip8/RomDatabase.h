@@ -0,0 +1,33 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+
+#include "Quirks.h"
+
+// Per-ROM settings from the community CHIP-8 database (https://github.com/chip-8/chip-8-database).
+// The directory must contain its programs.json and platforms.json; they are parsed on the first lookup.
+class RomDatabase
+{
+public:
+	struct RomInfo
+	{
+		std::string title;
+		std::string platform;
+		Quirks::Profile quirks;
+		int tickrate;	// instructions per 60 Hz frame, from the ROM or else its platform; 0 when neither has one
+	};
+
+	explicit RomDatabase(std::filesystem::path directory) : directory(std::move(directory)) {}
+
+	// sha1 is the lowercase hex digest of the ROM file.
+	const RomInfo* find(const std::string& sha1);
+	bool isAvailable();
+
+private:
+	std::filesystem::path directory;
+	std::unordered_map<std::string, RomInfo> roms;
+	bool loaded { false };
+
+	void load();
+};
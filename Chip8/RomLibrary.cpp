@@ -0,0 +1,254 @@
+#include "RomLibrary.h"
+#include "Sha1.h"
+#include "Archive.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <unordered_map>
+
+// Paths are stored as UTF-8 so index files written on one platform read back on another.
+static std::string toUtf8(const std::filesystem::path& path)
+{
+    const std::u8string utf8 = path.u8string();
+    return { utf8.begin(), utf8.end() };
+}
+
+static std::filesystem::path fromUtf8(const std::string& utf8)
+{
+    return std::u8string { utf8.begin(), utf8.end() };
+}
+
+static bool isRomFile(const std::filesystem::path& path)
+{
+    static constexpr const char* extensions[] = { ".ch8", ".c8", ".bin", ".sc8", ".xo8" };
+
+    // pong.ch8.gz is checked by the extension it had before compression.
+    if (Archive::hasExtension(path, ".gz"))
+        return isRomFile(path.stem());
+
+    return std::any_of(std::begin(extensions), std::end(extensions), [&](const char* extension) { return Archive::hasExtension(path, extension); });
+}
+
+static int64_t modifiedTime(const std::filesystem::path& path, std::error_code& error)
+{
+    return static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+}
+
+// A file to hash. Zip members keep the entry the scan listed, so each archive is listed only once.
+struct HashJob
+{
+    size_t index;
+    std::filesystem::path archive;
+    Archive::ZipEntry member;
+};
+
+// Hashes the decompressed ROM, so a ROM has the same SHA-1 whether it is loose, gzipped or in a zip.
+static std::string hashFile(const std::filesystem::path& path, const HashJob& job)
+{
+    constexpr size_t MaxRomSize = 64 * 1024;
+    std::vector<uint8_t> rom(MaxRomSize);
+    size_t size { 0 };
+
+    const LoadResult result = job.archive.empty() ? Archive::readRom(path, rom.data(), rom.size(), size)
+        : Archive::readZipMember(job.archive, job.member, rom.data(), rom.size(), size);
+    if (result != LoadResult::Ok) return {};
+    return Sha1::hash(rom.data(), size);
+}
+
+RomLibrary::RomLibrary(std::filesystem::path directoriesFile, std::filesystem::path indexFile)
+    : directoriesFile(std::move(directoriesFile)), indexFile(std::move(indexFile))
+{
+    loadDirectories();
+    entries = loadIndex();
+}
+
+RomLibrary::~RomLibrary()
+{
+    cancel = true;
+    if (scanner.joinable()) scanner.join();
+}
+
+void RomLibrary::addDirectory(const std::filesystem::path& directory)
+{
+    if (std::find(directories.begin(), directories.end(), directory) != directories.end())
+        return;
+
+    directories.push_back(directory);
+    saveDirectories();
+}
+
+void RomLibrary::removeDirectory(size_t index)
+{
+    if (index >= directories.size()) return;
+
+    directories.erase(directories.begin() + index);
+    saveDirectories();
+}
+
+void RomLibrary::scan()
+{
+    if (scanning) return;
+    if (scanner.joinable()) scanner.join();
+
+    scanning = true;
+    cancel = false;
+    scanner = std::thread(&RomLibrary::runScan, this, directories);
+}
+
+std::vector<RomLibrary::Entry> RomLibrary::getEntries() const
+{
+    std::lock_guard lock(entriesMutex);
+    return entries;
+}
+
+void RomLibrary::runScan(std::vector<std::filesystem::path> roots)
+{
+    std::unordered_map<std::string, Entry> cached;
+    for (Entry& entry : loadIndex())
+        cached.emplace(toUtf8(entry.path), std::move(entry));
+
+    std::vector<Entry> found;
+    std::vector<HashJob> stale;
+
+    for (const std::filesystem::path& root : roots)
+    {
+        std::error_code error;
+        for (auto it = std::filesystem::recursive_directory_iterator(root, std::filesystem::directory_options::skip_permission_denied, error);
+            it != std::filesystem::recursive_directory_iterator() && !cancel; it.increment(error))
+        {
+            if (error || !it->is_regular_file(error))
+                continue;
+
+            // Zip members are keyed by the archive's mtime and their own uncompressed size.
+            std::vector<Entry> files;
+            std::vector<HashJob> jobs;
+            if (Archive::hasExtension(it->path(), ".zip"))
+            {
+                std::vector<Archive::ZipEntry> members;
+                Archive::listZip(it->path(), members);
+
+                for (Archive::ZipEntry& member : members)
+                {
+                    if (!isRomFile(member.name)) continue;
+
+                    files.push_back({ it->path() / fromUtf8(member.name), member.size, modifiedTime(it->path(), error), {}, {} });
+                    jobs.push_back({ 0, it->path(), std::move(member) });
+                }
+            }
+            else if (isRomFile(it->path()))
+            {
+                files.push_back({ it->path(), it->file_size(error), modifiedTime(it->path(), error), {}, {} });
+                jobs.push_back({});
+            }
+
+            if (error) continue;
+
+            for (size_t i = 0; i < files.size(); i++)
+            {
+                Entry& entry = files[i];
+                entry.name = toUtf8(entry.path.filename());
+                const auto hit = cached.find(toUtf8(entry.path));
+                if (hit != cached.end() && hit->second.size == entry.size && hit->second.modified == entry.modified)
+                    entry.sha1 = hit->second.sha1;
+                else
+                {
+                    jobs[i].index = found.size();
+                    stale.push_back(std::move(jobs[i]));
+                }
+
+                found.push_back(std::move(entry));
+            }
+        }
+    }
+
+    hashed = 0;
+    pending = static_cast<int>(stale.size());
+
+    // Workers take the next stale file from a shared counter until the queue is drained.
+    std::atomic<size_t> next { 0 };
+    const auto worker = [&]()
+    {
+        for (size_t job = next++; job < stale.size() && !cancel; job = next++)
+        {
+            Entry& entry = found[stale[job].index];
+            entry.sha1 = hashFile(entry.path, stale[job]);
+            hashed++;
+        }
+    };
+
+    const size_t workerCount = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, std::max<size_t>(stale.size(), 1));
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < workerCount; i++)
+        workers.emplace_back(worker);
+    for (std::thread& thread : workers)
+        thread.join();
+
+    if (!cancel)
+    {
+        std::sort(found.begin(), found.end(), [](const Entry& a, const Entry& b) { return a.name < b.name; });
+        saveIndex(found);
+
+        std::lock_guard lock(entriesMutex);
+        entries = std::move(found);
+    }
+
+    scanning = false;
+}
+
+void RomLibrary::loadDirectories()
+{
+    std::ifstream ifs(directoriesFile);
+    std::string line;
+
+    while (std::getline(ifs, line))
+    {
+        if (!line.empty())
+            directories.push_back(fromUtf8(line));
+    }
+}
+
+void RomLibrary::saveDirectories() const
+{
+    std::ofstream ofs(directoriesFile);
+
+    for (const std::filesystem::path& directory : directories)
+        ofs << toUtf8(directory) << '\n';
+}
+
+// Index lines are: <sha1> <size> <modified> <path>, with the path running to the end of the line.
+// Files that failed to hash are left out, so the next scan tries them again.
+std::vector<RomLibrary::Entry> RomLibrary::loadIndex() const
+{
+    std::ifstream ifs(indexFile);
+    std::vector<Entry> index;
+    std::string line;
+
+    while (std::getline(ifs, line))
+    {
+        std::stringstream ss(line);
+        Entry entry {};
+        std::string path;
+
+        if (!(ss >> entry.sha1 >> entry.size >> entry.modified) || !std::getline(ss >> std::ws, path))
+            continue;
+
+        entry.path = fromUtf8(path);
+        entry.name = toUtf8(entry.path.filename());
+        index.push_back(std::move(entry));
+    }
+
+    return index;
+}
+
+void RomLibrary::saveIndex(const std::vector<Entry>& index) const
+{
+    std::ofstream ofs(indexFile);
+
+    for (const Entry& entry : index)
+    {
+        if (entry.sha1.empty()) continue;
+        ofs << entry.sha1 << ' ' << entry.size << ' ' << entry.modified << ' ' << toUtf8(entry.path) << '\n';
+    }
+}
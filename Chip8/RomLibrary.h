@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Index of the ROMs found under a set of directories.
+// Scans run on a background thread and hash new or changed files on a pool of workers;
+// results are cached on disk keyed by path, size and modification time.
+class RomLibrary
+{
+public:
+	struct Entry
+	{
+		std::filesystem::path path;
+		uintmax_t size;
+		int64_t modified;
+		std::string sha1;
+		// UTF-8 file name, kept for display and filtering.
+		std::string name;
+	};
+
+	RomLibrary(std::filesystem::path directoriesFile, std::filesystem::path indexFile);
+	~RomLibrary();
+
+	const std::vector<std::filesystem::path>& getDirectories() const { return directories; }
+	void addDirectory(const std::filesystem::path& directory);
+	void removeDirectory(size_t index);
+
+	void scan();
+	bool isScanning() const { return scanning.load(); }
+	// Files hashed and files queued for hashing by the running scan.
+	int hashedCount() const { return hashed.load(); }
+	int pendingCount() const { return pending.load(); }
+
+	std::vector<Entry> getEntries() const;
+
+private:
+	std::filesystem::path directoriesFile;
+	std::filesystem::path indexFile;
+	std::vector<std::filesystem::path> directories;
+
+	mutable std::mutex entriesMutex;
+	std::vector<Entry> entries;
+
+	std::thread scanner;
+	std::atomic<bool> scanning { false };
+	std::atomic<bool> cancel { false };
+	std::atomic<int> hashed { 0 };
+	std::atomic<int> pending { 0 };
+
+	void runScan(std::vector<std::filesystem::path> roots);
+	void loadDirectories();
+	void saveDirectories() const;
+	std::vector<Entry> loadIndex() const;
+	void saveIndex(const std::vector<Entry>& index) const;
+};
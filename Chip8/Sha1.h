@@ -0,0 +1,120 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// FIPS 180-1 SHA-1, used to identify ROMs the same way ROM databases do.
+class Sha1
+{
+public:
+	using Digest = std::array<uint8_t, 20>;
+
+	void update(const uint8_t* data, size_t size)
+	{
+		totalBytes += size;
+
+		while (size > 0)
+		{
+			const size_t chunk = std::min(size, block.size() - blockUsed);
+			std::memcpy(block.data() + blockUsed, data, chunk);
+			blockUsed += chunk;
+			data += chunk;
+			size -= chunk;
+
+			if (blockUsed == block.size())
+			{
+				processBlock();
+				blockUsed = 0;
+			}
+		}
+	}
+
+	Digest digest()
+	{
+		const uint64_t bitLength = totalBytes * 8;
+
+		const uint8_t one = 0x80;
+		update(&one, 1);
+
+		const uint8_t zero = 0;
+		while (blockUsed != 56)
+			update(&zero, 1);
+
+		uint8_t length[8];
+		for (int i = 0; i < 8; i++)
+			length[i] = static_cast<uint8_t>(bitLength >> (56 - i * 8));
+		update(length, 8);
+
+		Digest result;
+		for (int i = 0; i < 20; i++)
+			result[i] = static_cast<uint8_t>(state[i / 4] >> (24 - (i % 4) * 8));
+
+		return result;
+	}
+
+	static std::string toHex(const Digest& digest)
+	{
+		static constexpr char hexDigits[] = "0123456789abcdef";
+		std::string hex;
+
+		for (uint8_t byte : digest)
+		{
+			hex += hexDigits[byte >> 4];
+			hex += hexDigits[byte & 0xF];
+		}
+
+		return hex;
+	}
+	static std::string hash(const uint8_t* data, size_t size)
+	{
+		Sha1 sha1;
+		sha1.update(data, size);
+		return toHex(sha1.digest());
+	}
+
+private:
+	std::array<uint32_t, 5> state { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+	std::array<uint8_t, 64> block{};
+	size_t blockUsed { 0 };
+	uint64_t totalBytes { 0 };
+
+	static inline uint32_t rotl(uint32_t value, int bits)
+	{
+		return (value << bits) | (value >> (32 - bits));
+	}
+
+	void processBlock()
+	{
+		uint32_t w[80];
+		for (int i = 0; i < 16; i++)
+			w[i] = (block[i * 4] << 24) | (block[i * 4 + 1] << 16) | (block[i * 4 + 2] << 8) | block[i * 4 + 3];
+		for (int i = 16; i < 80; i++)
+			w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+		uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+
+		for (int i = 0; i < 80; i++)
+		{
+			uint32_t f, k;
+			if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+			else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+			else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+			else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+
+			const uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+			e = d;
+			d = c;
+			c = rotl(b, 30);
+			b = a;
+			a = temp;
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+	}
+};
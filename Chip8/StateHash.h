@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+
+// Zobrist-style keys for incrementally hashing machine state.
+// A zero byte and an unlit pixel both contribute 0, so cleared memory and a cleared screen hash to 0.
+namespace StateHash
+{
+	constexpr uint64_t mix(uint64_t x)
+	{
+		x += 0x9E3779B97F4A7C15;
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+		return x ^ (x >> 31);
+	}
+
+	constexpr uint64_t ramKey(uint16_t addr, uint8_t val)
+	{
+		return val ? mix((static_cast<uint64_t>(addr) << 8) | val) : 0;
+	}
+	constexpr uint64_t pixelKey(uint16_t index)
+	{
+		return mix(0x100000 | index);
+	}
+
+	constexpr uint64_t combine(uint64_t hash, uint64_t val)
+	{
+		return mix(hash ^ val);
+	}
+}
@@ -0,0 +1,85 @@
+// Simulates the beeper against a sound card whose clock runs at a slightly different rate than the
+// frame pacer, with and without Sync to Audio, and reports how the beeper's lead over playback behaves.
+// Usage: AudioSyncSim [hours] [audio clock offset in ppm] [period frames]
+// Defaults: 4 hours, +500 ppm (0.05% fast), 441-frame periods at 44100 Hz.
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "../Beeper.h"
+
+struct Result
+{
+	double minLead;
+	double maxLead;
+	double rateScale;
+	int reanchors;
+};
+
+static Result simulate(double seconds, double audioClock, uint32_t periodFrames, bool sync)
+{
+	constexpr uint32_t SampleRate = 44100;
+	// Lead samples from the first seconds, while playback settles, are left out of the range.
+	constexpr double SettleSeconds = 10.0;
+
+	Beeper beeper;
+	beeper.setSampleRate(SampleRate);
+	AudioRateControl rate;
+	std::vector<float> buffer(periodFrames);
+
+	Result result { 1.0, -1.0, 1.0, 0 };
+	uint64_t frames { 0 };
+	double frameTime { 0.0 }, audioTime { 0.0 };
+
+	// Both clocks run in host seconds; whichever is due next goes first.
+	while (frameTime < seconds)
+	{
+		if (frameTime <= audioTime)
+		{
+			if (sync) rate.update(beeper.getLead());
+			beeper.advance(static_cast<double>(++frames) / 60.0);
+			frameTime += 1.0 / (60.0 * rate.getRateScale());
+			continue;
+		}
+
+		// Beeper::render re-anchors playback when the lead leaves [-MaxLag, MaxLead].
+		const double lead = beeper.getLead();
+		if (lead > Beeper::MaxLead || lead < -Beeper::MaxLag) result.reanchors++;
+
+		beeper.render(buffer.data(), periodFrames, 1);
+		audioTime += periodFrames / (SampleRate * audioClock);
+
+		if (audioTime > SettleSeconds)
+		{
+			result.minLead = std::min(result.minLead, beeper.getLead());
+			result.maxLead = std::max(result.maxLead, beeper.getLead());
+		}
+	}
+
+	result.rateScale = rate.getRateScale();
+	return result;
+}
+
+int main(int argc, char* argv[])
+{
+	const double hours = argc > 1 ? std::atof(argv[1]) : 4.0;
+	const double ppm = argc > 2 ? std::atof(argv[2]) : 500.0;
+	const int periodFrames = argc > 3 ? std::atoi(argv[3]) : 441;
+
+	if (hours <= 0.0 || periodFrames <= 0)
+	{
+		std::fprintf(stderr, "Usage: AudioSyncSim [hours] [audio clock offset in ppm] [period frames]\n");
+		return 1;
+	}
+
+	std::printf("%.2f h, audio clock %+.0f ppm, %d-frame periods\n", hours, ppm, periodFrames);
+	for (const bool sync : { false, true })
+	{
+		const Result result = simulate(hours * 3600.0, 1.0 + ppm / 1e6, periodFrames, sync);
+		std::printf("Sync %-3s lead %5.1f..%5.1f ms, %d re-anchors, final rate %+.3f%%\n", sync ? "on" : "off",
+			result.minLead * 1000.0, result.maxLead * 1000.0, result.reanchors, (result.rateScale - 1.0) * 100.0);
+	}
+
+	return 0;
+}
@@ -0,0 +1,43 @@
+// Static disassembly of a ROM as it is laid out in memory from 0x200.
+// Usage: Disassemble <rom.ch8> [--odd]
+// --odd starts decoding at 0x201, for ROMs that place code on odd addresses.
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "../Disassembler.h"
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Usage: Disassemble <rom.ch8> [--odd]\n";
+		return 1;
+	}
+
+	std::ifstream ifs(argv[1], std::ios::binary);
+	if (!ifs)
+	{
+		std::cerr << "Cannot open " << argv[1] << "\n";
+		return 1;
+	}
+
+	const std::vector<uint8_t> rom { std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>() };
+	const bool odd = argc > 2 && std::string(argv[2]) == "--odd";
+
+	PagedRAM ram;
+	ram.copyFrom(0x200, rom.data(), rom.size());
+
+	DisassemblyCache disassembly;
+	disassembly.update(ram);
+
+	const int end = std::min<int>(0x200 + static_cast<int>(rom.size()), PagedRAM::Size);
+	for (int addr = 0x200 + odd; addr < end; addr += 2)
+		std::printf("%03X  %04X  %s\n", addr, disassembly.opcode(addr), disassembly.text(addr));
+
+	return 0;
+}
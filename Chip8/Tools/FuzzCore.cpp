@@ -0,0 +1,78 @@
+// libFuzzer / AFL++ target for the CPU core.
+// Input layout: [quirk bits] [key mask lo] [key mask hi] [frames] [ROM bytes loaded at 0x200...]
+// Each input runs on the reference and table engines in lockstep and aborts on any divergence;
+// out-of-bounds accesses are left to the sanitizers.
+//
+// libFuzzer:  clang++ -std=c++20 -O1 -g -fsanitize=fuzzer,address,undefined -I.. -I../Libs FuzzCore.cpp ../Differential.cpp -o FuzzCore
+// Replay:     g++ -std=c++20 -g -fsanitize=address,undefined -DCHIP8_FUZZ_MAIN -I.. -I../Libs FuzzCore.cpp ../Differential.cpp -o FuzzCore -lpthread -ldl -lm
+#define MINIAUDIO_IMPLEMENTATION
+#include "MiniAudio/miniaudio.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <vector>
+
+#include "../ChipCore.h"
+#include "../Differential.h"
+
+static constexpr size_t headerSize = 4;
+static constexpr int maxFrames = 64;
+static constexpr int cyclesPerFrame = 32;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	static ChipCore reference { false };
+	static ChipCore candidate { false };
+	candidate.engine = ChipCore::Engine::Table;
+
+	if (size < headerSize) return 0;
+
+	const uint8_t quirkBits = data[0];
+	Quirks::VFReset = quirkBits & 1;
+	Quirks::MemoryIncrement = quirkBits & 2;
+	Quirks::Clipping = quirkBits & 4;
+	Quirks::Shifting = quirkBits & 8;
+	Quirks::Jumping = quirkBits & 16;
+
+	const std::span<const uint8_t> rom { data + headerSize, std::min(size - headerSize, ChipCore::MaxROMSize) };
+	reference.loadROM(rom);
+	candidate.loadROM(rom);
+
+	const uint16_t keyMask = data[1] | (data[2] << 8);
+	for (uint8_t key = 0; key < 16; key++)
+	{
+		reference.setKey(key, keyMask & (1 << key));
+		candidate.setKey(key, keyMask & (1 << key));
+	}
+
+	const int frames = 1 + data[3] % maxFrames;
+	const auto divergence = runLockstep(reference, candidate, frames, cyclesPerFrame, cyclesPerFrame, quirkBits);
+
+	if (divergence)
+	{
+		std::fprintf(stderr, "Engines diverged at step %llu, pc 0x%03X, opcode %04X: %s\n",
+			static_cast<unsigned long long>(divergence->step), divergence->pc, divergence->opcode, divergence->field.c_str());
+		std::abort();
+	}
+
+	return 0;
+}
+
+#ifdef CHIP8_FUZZ_MAIN
+int main(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::ifstream ifs(argv[i], std::ios::binary);
+		const std::vector<uint8_t> input { std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>() };
+
+		LLVMFuzzerTestOneInput(input.data(), input.size());
+	}
+
+	return 0;
+}
+#endif
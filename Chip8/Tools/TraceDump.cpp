@@ -0,0 +1,85 @@
+// Decodes and filters trace files written by the Debug -> Trace menu.
+// Usage: TraceDump <trace.c8t> [--pc lo hi] [--op mask value] [--cycles from to] [--reg x]
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../Trace.h"
+
+struct Filter
+{
+	uint16_t pcLow { 0 }, pcHigh { 0xFFF };
+	uint16_t opMask { 0 }, opValue { 0 };
+	uint64_t cycleFrom { 0 }, cycleTo { UINT64_MAX };
+	int reg { -1 };
+
+	bool matches(const TraceEntry& entry) const
+	{
+		return entry.pc >= pcLow && entry.pc <= pcHigh &&
+			(entry.opcode & opMask) == opValue &&
+			entry.cycle >= cycleFrom && entry.cycle <= cycleTo &&
+			(reg < 0 || entry.reg == reg);
+	}
+};
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Usage: TraceDump <trace.c8t> [--pc lo hi] [--op mask value] [--cycles from to] [--reg x]\n";
+		return 1;
+	}
+
+	Filter filter {};
+	for (int i = 2; i < argc; i++)
+	{
+		const std::string arg { argv[i] };
+		const auto next = [&](int base) { return i + 1 < argc ? std::strtoull(argv[++i], nullptr, base) : 0; };
+
+		if (arg == "--pc") { filter.pcLow = next(16); filter.pcHigh = next(16); }
+		else if (arg == "--op") { filter.opMask = next(16); filter.opValue = next(16); }
+		else if (arg == "--cycles") { filter.cycleFrom = next(10); filter.cycleTo = next(10); }
+		else if (arg == "--reg") filter.reg = static_cast<int>(next(16));
+		else
+		{
+			std::cerr << "Unknown option " << arg << "\n";
+			return 1;
+		}
+	}
+
+	std::ifstream ifs(argv[1], std::ios::binary);
+	TraceFileHeader header;
+
+	if (!ifs.read(reinterpret_cast<char*>(&header), sizeof(header)) || !isValidTraceHeader(header))
+	{
+		std::cerr << "Not a trace file: " << argv[1] << "\n";
+		return 1;
+	}
+
+	std::vector<TraceEntry> chunk(1 << 16);
+	uint64_t total {}, shown {};
+
+	while (ifs)
+	{
+		ifs.read(reinterpret_cast<char*>(chunk.data()), chunk.size() * sizeof(TraceEntry));
+		const size_t count = static_cast<size_t>(ifs.gcount()) / sizeof(TraceEntry);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const TraceEntry& entry = chunk[i];
+			if (!filter.matches(entry)) continue;
+
+			std::printf("%12llu  %03X  %04X  I=%03X  V%X=%02X\n", static_cast<unsigned long long>(entry.cycle),
+				entry.pc, entry.opcode, entry.I, entry.reg, entry.value);
+			shown++;
+		}
+
+		total += count;
+	}
+
+	std::fprintf(stderr, "%llu of %llu entries shown\n", static_cast<unsigned long long>(shown), static_cast<unsigned long long>(total));
+	return 0;
+}
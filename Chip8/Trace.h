@@ -0,0 +1,170 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+struct TraceEntry
+{
+	uint64_t cycle;
+	uint16_t pc;
+	uint16_t opcode;
+	uint16_t I;
+	uint8_t reg;	// X operand of the opcode
+	uint8_t value;	// V[X] after the opcode executed
+};
+static_assert(sizeof(TraceEntry) == 16);
+
+// Trace files are a TraceFileHeader followed by raw TraceEntry records.
+struct TraceFileHeader
+{
+	char magic[4] { 'C', '8', 'T', 'R' };
+	uint16_t version { 1 };
+	uint16_t entrySize { sizeof(TraceEntry) };
+};
+
+inline bool isValidTraceHeader(const TraceFileHeader& header)
+{
+	return std::memcmp(header.magic, "C8TR", 4) == 0 && header.version == 1 && header.entrySize == sizeof(TraceEntry);
+}
+
+// Single producer ring that never blocks the emulator: when full, the oldest entries are overwritten.
+// A reader that falls behind skips the lost entries and counts them as dropped.
+class TraceRing
+{
+public:
+	explicit TraceRing(size_t capacityLog2) : entries(size_t { 1 } << capacityLog2), mask(entries.size() - 1) {}
+
+	inline void push(const TraceEntry& entry)
+	{
+		const uint64_t index = head.load(std::memory_order_relaxed);
+		entries[index & mask] = entry;
+		head.store(index + 1, std::memory_order_release);
+		// Seqlock-style: the next push's slot write must not become visible before this head store,
+		// otherwise a reader could copy that half-written slot while still seeing the old head.
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	size_t capacity() const { return entries.size(); }
+	uint64_t written() const { return head.load(std::memory_order_acquire); }
+
+	// Copies up to maxCount entries starting at tail and advances tail.
+	size_t read(uint64_t& tail, TraceEntry* out, size_t maxCount, uint64_t& dropped) const
+	{
+		uint64_t end = head.load(std::memory_order_acquire);
+		if (end - tail > entries.size())
+		{
+			dropped += end - entries.size() - tail;
+			tail = end - entries.size();
+		}
+
+		const size_t count = static_cast<size_t>(std::min<uint64_t>(end - tail, maxCount));
+		for (size_t i = 0; i < count; i++)
+			out[i] = entries[(tail + i) & mask];
+
+		// Entries the producer lapped while they were being copied are torn, discard them. The fence keeps
+		// the copies above from being reordered after the head load, and the slot of entry `end` may be
+		// mid-write, so it counts as lapped too. The fence in push keeps any later slot write from being
+		// seen before the head that precedes it, so no slot past `end` can be torn.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		end = head.load(std::memory_order_relaxed);
+		const uint64_t oldestValid = end + 1 > entries.size() ? end + 1 - entries.size() : 0;
+		size_t valid = count;
+		size_t skip = 0;
+
+		if (tail < oldestValid)
+		{
+			skip = static_cast<size_t>(std::min<uint64_t>(oldestValid - tail, count));
+			dropped += skip;
+			valid -= skip;
+			std::memmove(out, out + skip, valid * sizeof(TraceEntry));
+		}
+
+		tail += count;
+		return valid;
+	}
+
+	// Writes the most recent entries still held by the ring, oldest first.
+	bool dumpRecent(const char* path) const
+	{
+		std::ofstream ofs(path, std::ios::binary);
+		if (!ofs) return false;
+
+		const TraceFileHeader header {};
+		ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		const uint64_t end = written();
+		uint64_t tail = end > entries.size() ? end - entries.size() : 0;
+		uint64_t dropped {};
+		std::vector<TraceEntry> chunk(4096);
+
+		while (tail < end)
+		{
+			const size_t count = read(tail, chunk.data(), std::min<uint64_t>(chunk.size(), end - tail), dropped);
+			ofs.write(reinterpret_cast<const char*>(chunk.data()), count * sizeof(TraceEntry));
+		}
+
+		return ofs.good();
+	}
+
+private:
+	std::vector<TraceEntry> entries;
+	const uint64_t mask;
+	std::atomic<uint64_t> head { 0 };
+};
+
+// Background thread that streams everything pushed into a TraceRing to a trace file.
+class TraceWriter
+{
+public:
+	TraceWriter(const TraceRing& ring, const char* path) : ring(ring), ofs(path, std::ios::binary)
+	{
+		const TraceFileHeader header {};
+		ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		tail = ring.written();
+		worker = std::thread(&TraceWriter::run, this);
+	}
+	~TraceWriter()
+	{
+		running = false;
+		worker.join();
+	}
+
+	bool isOpen() const { return ofs.is_open(); }
+	uint64_t droppedEntries() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+	const TraceRing& ring;
+	std::ofstream ofs;
+	std::thread worker;
+	std::atomic<bool> running { true };
+	std::atomic<uint64_t> dropped { 0 };
+	uint64_t tail {};
+
+	void run()
+	{
+		std::vector<TraceEntry> chunk(1 << 16);
+		uint64_t lost {};
+
+		while (true)
+		{
+			const bool stopping = !running.load();
+			const size_t count = ring.read(tail, chunk.data(), chunk.size(), lost);
+			dropped.store(lost, std::memory_order_relaxed);
+
+			if (count > 0)
+				ofs.write(reinterpret_cast<const char*>(chunk.data()), count * sizeof(TraceEntry));
+			else if (stopping)
+				break;
+			else
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		ofs.flush();
+	}
+};
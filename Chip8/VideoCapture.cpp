@@ -0,0 +1,329 @@
+#include "VideoCapture.h"
+#include "ChipCore.h"
+#include "RomDatabase.h"
+#include "Sha1.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+VideoCapture::VideoCapture(const std::filesystem::path& path, int scale, uint32_t foreground, uint32_t background) :
+    format(formatFor(path)), scale(std::clamp(scale, 1, 16)), palette { background, foreground }, ofs(path, std::ios::binary)
+{
+    pixels.resize(static_cast<size_t>(width()) * height() * 3);
+    encoded.reserve(pixels.size());
+    if (format == Format::Gif) gifCodes.resize(4096);
+
+    writeHeader();
+    worker = std::thread(&VideoCapture::run, this);
+}
+
+VideoCapture::~VideoCapture()
+{
+    running = false;
+    worker.join();
+}
+
+VideoCapture::Format VideoCapture::formatFor(const std::filesystem::path& path)
+{
+    if (Archive::hasExtension(path, ".y4m")) return Format::Y4M;
+    if (Archive::hasExtension(path, ".gif")) return Format::Gif;
+    return Format::RawRGB;
+}
+
+bool VideoCapture::push(const Frame& frame)
+{
+    const size_t index = head.load(std::memory_order_relaxed);
+    if (index - tail.load(std::memory_order_acquire) == QueueCapacity)
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    queue[index % QueueCapacity] = frame;
+    head.store(index + 1, std::memory_order_release);
+    return true;
+}
+
+void VideoCapture::pushWait(const Frame& frame)
+{
+    const size_t index = head.load(std::memory_order_relaxed);
+    while (index - tail.load(std::memory_order_acquire) == QueueCapacity)
+        std::this_thread::yield();
+
+    queue[index % QueueCapacity] = frame;
+    head.store(index + 1, std::memory_order_release);
+}
+
+void VideoCapture::run()
+{
+    while (true)
+    {
+        const bool stopping = !running.load();
+        const size_t index = tail.load(std::memory_order_relaxed);
+
+        if (index != head.load(std::memory_order_acquire))
+        {
+            writeFrame(queue[index % QueueCapacity]);
+            tail.store(index + 1, std::memory_order_release);
+            written.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (stopping)
+            break;
+        else
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    writeTrailer();
+    ofs.flush();
+}
+
+// Fills out with one value (of channels bytes) per scaled pixel, values[0] for off and values[channels] for on.
+void VideoCapture::scaleFrame(const Frame& frame, const uint8_t* values, int channels, uint8_t* out) const
+{
+    const size_t rowBytes = static_cast<size_t>(width()) * channels;
+
+    for (int y = 0; y < FrameHeight; y++)
+    {
+        uint8_t* row = out + y * scale * rowBytes;
+        uint8_t* pixel = row;
+
+        for (int x = 0; x < FrameWidth; x++)
+        {
+            const uint8_t* value = values + (frame[FrameWidth * y + x] ? channels : 0);
+            for (int i = 0; i < scale; i++, pixel += channels)
+                std::memcpy(pixel, value, channels);
+        }
+
+        for (int i = 1; i < scale; i++)
+            std::memcpy(row + i * rowBytes, row, rowBytes);
+    }
+}
+
+static uint8_t channel(uint32_t color, int shift)
+{
+    return static_cast<uint8_t>((color >> shift) & 0xFF);
+}
+
+void VideoCapture::writeHeader()
+{
+    if (format == Format::Y4M)
+        ofs << "YUV4MPEG2 W" << width() << " H" << height() << " F60:1 Ip A1:1 C444\n";
+
+    if (format != Format::Gif)
+        return;
+
+    const uint8_t header[] =
+    {
+        'G', 'I', 'F', '8', '9', 'a',
+        static_cast<uint8_t>(width()), static_cast<uint8_t>(width() >> 8),
+        static_cast<uint8_t>(height()), static_cast<uint8_t>(height() >> 8),
+        0x80, 0, 0,		// two-entry global color table
+        channel(palette[0], 16), channel(palette[0], 8), channel(palette[0], 0),
+        channel(palette[1], 16), channel(palette[1], 8), channel(palette[1], 0),
+        0x21, 0xFF, 11, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E', '2', '.', '0', 3, 1, 0, 0, 0		// loop forever
+    };
+    ofs.write(reinterpret_cast<const char*>(header), sizeof(header));
+}
+
+void VideoCapture::writeFrame(const Frame& frame)
+{
+    const size_t planeSize = static_cast<size_t>(width()) * height();
+
+    switch (format)
+    {
+    case Format::Y4M:
+    {
+        // BT.601 limited range.
+        uint8_t planes[3][2];
+        for (int i = 0; i < 2; i++)
+        {
+            const double r = channel(palette[i], 16), g = channel(palette[i], 8), b = channel(palette[i], 0);
+            planes[0][i] = static_cast<uint8_t>(std::lround(16 + (65.481 * r + 128.553 * g + 24.966 * b) / 255));
+            planes[1][i] = static_cast<uint8_t>(std::lround(128 + (-37.797 * r - 74.203 * g + 112.0 * b) / 255));
+            planes[2][i] = static_cast<uint8_t>(std::lround(128 + (112.0 * r - 93.786 * g - 18.214 * b) / 255));
+        }
+
+        for (int plane = 0; plane < 3; plane++)
+            scaleFrame(frame, planes[plane], 1, pixels.data() + plane * planeSize);
+
+        ofs << "FRAME\n";
+        ofs.write(reinterpret_cast<const char*>(pixels.data()), planeSize * 3);
+        break;
+    }
+    case Format::RawRGB:
+    {
+        const uint8_t values[6] =
+        {
+            channel(palette[0], 16), channel(palette[0], 8), channel(palette[0], 0),
+            channel(palette[1], 16), channel(palette[1], 8), channel(palette[1], 0)
+        };
+
+        scaleFrame(frame, values, 3, pixels.data());
+        ofs.write(reinterpret_cast<const char*>(pixels.data()), planeSize * 3);
+        break;
+    }
+    case Format::Gif:
+    {
+        // GIF delays are in hundredths of a second and most viewers slow anything under 2 down,
+        // so a frame is held back until it has lasted that long and replaced if it changes sooner.
+        if (frameIndex == 0)
+            gifPending = frame;
+        else if (frame != gifPending)
+        {
+            const int delay = gifDelay();
+            if (delay >= 2)
+            {
+                writeGifImage(gifPending, delay);
+                gifPendingStart = frameIndex;
+            }
+            gifPending = frame;
+        }
+        break;
+    }
+    }
+
+    frameIndex++;
+}
+
+int VideoCapture::gifDelay() const
+{
+    return static_cast<int>(frameIndex * 100 / 60 - gifPendingStart * 100 / 60);
+}
+
+void VideoCapture::writeTrailer()
+{
+    if (format != Format::Gif || frameIndex == 0)
+        return;
+
+    writeGifImage(gifPending, std::max(2, gifDelay()));
+    ofs.put(0x3B);
+}
+
+// LZW with a minimum code size of 2, the smallest GIF allows for a two-color image.
+void VideoCapture::writeGifImage(const Frame& frame, int delay)
+{
+    constexpr int MinCodeSize = 2;
+    constexpr uint16_t ClearCode = 1 << MinCodeSize;
+    constexpr uint16_t EndCode = ClearCode + 1;
+    constexpr uint16_t MaxCode = 4095;
+
+    const uint8_t values[2] = { 0, 1 };
+    scaleFrame(frame, values, 1, pixels.data());
+
+    const uint8_t header[] =
+    {
+        0x21, 0xF9, 4, 0, static_cast<uint8_t>(delay), static_cast<uint8_t>(delay >> 8), 0, 0,
+        0x2C, 0, 0, 0, 0,
+        static_cast<uint8_t>(width()), static_cast<uint8_t>(width() >> 8),
+        static_cast<uint8_t>(height()), static_cast<uint8_t>(height() >> 8),
+        0, MinCodeSize
+    };
+    ofs.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    std::fill(gifCodes.begin(), gifCodes.end(), std::array<uint16_t, 2> {});
+
+    encoded.clear();
+    uint32_t bits { 0 };
+    int bitCount { 0 };
+    int codeSize { MinCodeSize + 1 };
+    uint16_t lastCode { EndCode };
+
+    const auto emit = [&](uint16_t code)
+    {
+        bits |= static_cast<uint32_t>(code) << bitCount;
+        for (bitCount += codeSize; bitCount >= 8; bitCount -= 8, bits >>= 8)
+            encoded.push_back(static_cast<uint8_t>(bits));
+    };
+
+    emit(ClearCode);
+    const size_t count = static_cast<size_t>(width()) * height();
+    uint16_t prefix = pixels[0];
+
+    for (size_t i = 1; i < count; i++)
+    {
+        const uint8_t pixel = pixels[i];
+        if (gifCodes[prefix][pixel] != 0)
+        {
+            prefix = gifCodes[prefix][pixel];
+            continue;
+        }
+
+        emit(prefix);
+        gifCodes[prefix][pixel] = ++lastCode;
+        if (lastCode >= (1u << codeSize)) codeSize++;
+
+        if (lastCode == MaxCode)
+        {
+            emit(ClearCode);
+            std::fill(gifCodes.begin(), gifCodes.end(), std::array<uint16_t, 2> {});
+            codeSize = MinCodeSize + 1;
+            lastCode = EndCode;
+        }
+        prefix = pixel;
+    }
+
+    emit(prefix);
+    emit(EndCode);
+    if (bitCount > 0) encoded.push_back(static_cast<uint8_t>(bits));
+
+    for (size_t pos = 0; pos < encoded.size(); pos += 255)
+    {
+        const size_t blockSize = std::min<size_t>(255, encoded.size() - pos);
+        ofs.put(static_cast<char>(blockSize));
+        ofs.write(reinterpret_cast<const char*>(encoded.data() + pos), blockSize);
+    }
+    ofs.put(0);
+}
+
+int runRecording(const char* romPath, const char* outputPath, int frames, int scale)
+{
+    ChipCore core { false };
+    uint8_t rom[ChipCore::MaxROMSize];
+    size_t size { 0 };
+
+    LoadResult loaded = Archive::readRom(romPath, rom, sizeof(rom), size);
+    if (loaded == LoadResult::Ok) loaded = core.loadROM(std::span<const uint8_t>(rom, size));
+    if (loaded != LoadResult::Ok)
+    {
+        std::cout << romPath << ": " << describe(loaded) << '\n';
+        return 1;
+    }
+    core.seed(0);
+
+    // Quirks and speed come from the ROM database when it is installed, as in the frontend.
+    RomDatabase database("data/chip-8-database");
+    if (const RomDatabase::RomInfo* info = database.find(Sha1::hash(rom, size)))
+    {
+        Quirks::Apply(info->quirks);
+        if (info->tickrate > 0) core.CPUfrequency = info->tickrate * 60;
+    }
+
+    VideoCapture capture(outputPath, scale, 0xFFFFFF, 0x000000);
+    if (!capture.isOpen())
+    {
+        std::cout << outputPath << ": cannot open for writing\n";
+        return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    double remainder { 0 };
+
+    for (int frame = 0; frame < frames; frame++)
+    {
+        const double cycles = core.CPUfrequency / 60.0 + remainder;
+        remainder = cycles - static_cast<int>(cycles);
+
+        core.updateTimers();
+        core.runCycles(static_cast<int>(cycles));
+        capture.pushWait(core.getScreenBuffer());
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << outputPath << ": " << frames << " frames " << capture.width() << 'x' << capture.height()
+        << " in " << seconds << " s\n";
+    return 0;
+}
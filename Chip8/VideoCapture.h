@@ -0,0 +1,79 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+// Records framebuffers to a video file at 60 frames per second.
+// The format follows the extension: .y4m is YUV4MPEG2 (4:4:4), .gif is an animated GIF
+// and anything else is headerless RGB24. Frames are scaled up by an integer factor.
+// push() copies the 256-byte framebuffer into a preallocated ring and returns at once;
+// scaling and encoding happen on a background thread.
+class VideoCapture
+{
+public:
+	static constexpr int FrameWidth = 64;
+	static constexpr int FrameHeight = 32;
+	static constexpr size_t QueueCapacity = 256;
+
+	using Frame = std::bitset<FrameWidth * FrameHeight>;
+	enum class Format { Y4M, RawRGB, Gif };
+
+	// Colors are 0xRRGGBB.
+	VideoCapture(const std::filesystem::path& path, int scale, uint32_t foreground, uint32_t background);
+	~VideoCapture();
+
+	static Format formatFor(const std::filesystem::path& path);
+
+	bool isOpen() const { return ofs.is_open(); }
+	int width() const { return FrameWidth * scale; }
+	int height() const { return FrameHeight * scale; }
+
+	// Drops the frame and counts it if the writer has fallen a full queue behind.
+	bool push(const Frame& frame);
+	// Waits for room instead of dropping, for headless recording at uncapped speed.
+	void pushWait(const Frame& frame);
+
+	uint64_t framesWritten() const { return written.load(std::memory_order_relaxed); }
+	uint64_t droppedFrames() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+	const Format format;
+	const int scale;
+	const std::array<uint32_t, 2> palette;
+	std::ofstream ofs;
+
+	std::array<Frame, QueueCapacity> queue{};
+	std::atomic<size_t> head { 0 };
+	std::atomic<size_t> tail { 0 };
+
+	std::thread worker;
+	std::atomic<bool> running { true };
+	std::atomic<uint64_t> written { 0 };
+	std::atomic<uint64_t> dropped { 0 };
+
+	// Writer thread state.
+	std::vector<uint8_t> pixels;
+	std::vector<uint8_t> encoded;
+	// Child codes of each LZW code for the pixel values 0 and 1, 0 when there is none yet.
+	std::vector<std::array<uint16_t, 2>> gifCodes;
+	Frame gifPending{};
+	uint64_t gifPendingStart { 0 };
+	uint64_t frameIndex { 0 };
+
+	void run();
+	void writeHeader();
+	void writeFrame(const Frame& frame);
+	void writeTrailer();
+	void scaleFrame(const Frame& frame, const uint8_t* values, int channels, uint8_t* out) const;
+	// Hundredths of a second the pending GIF frame has been on screen.
+	int gifDelay() const;
+	void writeGifImage(const Frame& frame, int delay);
+};
+
+// Runs a ROM headless at uncapped speed for a number of frames and records every frame.
+int runRecording(const char* romPath, const char* outputPath, int frames, int scale);